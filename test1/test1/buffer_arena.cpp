@@ -0,0 +1,98 @@
+#include "buffer_arena.h"
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+buffer_arena::buffer_arena(size_t bytes, bool use_huge_pages)
+{
+    size_ = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    if (size_ == 0)
+        size_ = HUGE_PAGE_SIZE;
+
+#if defined(_WIN32)
+    // ҳҪSeLockMemoryPrivilegeȨޣͲᱻ
+    const SIZE_T large_page = GetLargePageMinimum();
+    if (use_huge_pages && large_page != 0 && size_ % large_page == 0)
+    {
+        mapping_ = static_cast<char*>(VirtualAlloc(nullptr, size_,
+            MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE));
+        if (mapping_ != nullptr)
+        {
+            page_kind_ = "2MB large pages";
+            locked_ = true;
+        }
+    }
+    if (mapping_ == nullptr)
+    {
+        mapping_ = static_cast<char*>(VirtualAlloc(nullptr, size_, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+        if (mapping_ == nullptr)
+            throw std::bad_alloc();
+        // ĬϵС̫СVirtualLockʧ
+        SIZE_T min_ws = 0, max_ws = 0;
+        if (GetProcessWorkingSetSize(GetCurrentProcess(), &min_ws, &max_ws))
+            SetProcessWorkingSetSize(GetCurrentProcess(), min_ws + size_, max_ws + size_);
+        locked_ = VirtualLock(mapping_, size_) != 0;
+    }
+    mapped_ = size_;
+    base_ = mapping_;
+#else
+#if defined(MAP_HUGETLB)
+    // ʽҳҪԤ(vm.nr_hugepages)ʱ˻ͨӳ
+    if (use_huge_pages)
+    {
+        void* p = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED)
+        {
+            mapping_ = base_ = static_cast<char*>(p);
+            mapped_ = size_;
+            page_kind_ = "2MB hugetlb pages";
+        }
+    }
+#endif
+    if (mapping_ == nullptr)
+    {
+        // ӳһҳʼַ뵽2MB͸ҳܸ
+        mapped_ = size_ + HUGE_PAGE_SIZE;
+        void* p = mmap(nullptr, mapped_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+            throw std::bad_alloc();
+        mapping_ = static_cast<char*>(p);
+        const uintptr_t addr = reinterpret_cast<uintptr_t>(mapping_);
+        base_ = reinterpret_cast<char*>((addr + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE);
+#if defined(MADV_HUGEPAGE)
+        if (use_huge_pages && madvise(base_, size_, MADV_HUGEPAGE) == 0)
+            page_kind_ = "transparent huge pages";
+#endif
+    }
+    // RLIMIT_MEMLOCKʱʧܣԿɼ
+    locked_ = mlock(base_, size_) == 0;
+#endif
+
+    // ҳд룬ȱҳȫ׶
+    std::memset(base_, 0, size_);
+}
+
+buffer_arena::~buffer_arena()
+{
+#if defined(_WIN32)
+    VirtualFree(mapping_, 0, MEM_RELEASE);
+#else
+    munmap(mapping_, mapped_);
+#endif
+}
+
+void* buffer_arena::allocate(size_t bytes)
+{
+    const size_t n = footprint(bytes);
+    if (n > size_ - used_)
+        throw std::bad_alloc();
+    void* p = base_ + used_;
+    used_ += n;
+    return p;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+
+// շ干õһڴ
+// ʱһԷ䣺ʹ2MBҳڴ(mlock)ҳдԤȴȱҳ
+// ڼallocate()ָֻڴ桢Ҳٳȱҳ
+class buffer_arena
+{
+public:
+    static constexpr size_t HUGE_PAGE_SIZE = size_t(2) << 20;
+    static constexpr size_t ALIGNMENT = 4096; // allocate()صĵַҳ
+
+    explicit buffer_arena(size_t bytes, bool use_huge_pages = true);
+    ~buffer_arena();
+
+    buffer_arena(const buffer_arena&) = delete;
+    buffer_arena& operator=(const buffer_arena&) = delete;
+
+    // arenaгһ飬ռ䲻ʱ׳std::bad_alloc
+    void* allocate(size_t bytes);
+
+    // һallocate(bytes)ʵռõĿռ䣬ԤȼarenaС
+    static size_t footprint(size_t bytes) { return (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT; }
+
+    size_t size() const { return size_; }
+    size_t used() const { return used_; }
+    const char* page_kind() const { return page_kind_; }
+    bool locked() const { return locked_; }
+
+private:
+    char* base_ = nullptr;
+    size_t size_ = 0;
+    size_t used_ = 0;
+    size_t mapped_ = 0;        // ʵӳֽΪӳĲ֣
+    char* mapping_ = nullptr;
+    const char* page_kind_ = "4KB pages";
+    bool locked_ = false;
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+// дСʹñ׼ֵ
+// ֻڱڲʹã漰ABIGCCڸֵѡ仯ľ
+#if defined(__cpp_lib_hardware_interference_size)
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winterference-size"
+#endif
+constexpr size_t CACHE_LINE_SIZE = std::hardware_destructive_interference_size;
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#else
+constexpr size_t CACHE_LINE_SIZE = 64;
+#endif
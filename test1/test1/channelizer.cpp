@@ -0,0 +1,50 @@
+#include "channelizer.h"
+#include "fir.h"
+#include <stdexcept>
+
+pfb_channelizer::pfb_channelizer(size_t channels, size_t taps_per_channel)
+    : m_(channels), fft_(channels)
+{
+    if (taps_per_channel == 0)
+        throw std::invalid_argument("Channelizer needs at least one tap per channel");
+    const size_t taps = channels * taps_per_channel;
+    // ֹƵΪŵһ룬ŵڱش-6dB
+    const std::vector<float> h = design_lowpass(taps, 0.5 / double(channels));
+    g_.resize(2 * taps);
+    for (size_t i = 0; i < taps; i++)
+        g_[2 * i] = g_[2 * i + 1] = h[taps - 1 - i];
+}
+
+size_t pfb_channelizer::process(const std::complex<float>* y, int64_t base, int64_t from, int64_t to,
+    std::complex<float>* out, std::complex<float>* scratch, int64_t* first) const
+{
+    const int64_t m = int64_t(m_);
+    const int64_t f0 = ceil_div(from, m);
+    const int64_t f1 = ceil_div(to, m);
+    *first = f0;
+    if (f1 <= f0)
+        return 0;
+
+    // ŵk = sum(h[n] * y[t - n] * exp(2*pi*i*k*n/M))k/Mź±ƵƵ
+    // y[t - L + 1 .. t]ϵȨÿM۵ӣr[k] = sum_p u[k + p*M]
+    // m֧v[m] = r[M - 1 - m]vMFFT
+    const size_t taps = num_taps();
+    const size_t mf = 2 * m_;
+    float* r = reinterpret_cast<float*>(scratch);
+    for (int64_t f = f0; f < f1; f++)
+    {
+        const float* w = reinterpret_cast<const float*>(y + (f * m - int64_t(taps) + 1 - base));
+        for (size_t i = 0; i < mf; i++)
+            r[i] = g_[i] * w[i];
+        for (size_t p = mf; p < 2 * taps; p += mf)
+        {
+            for (size_t i = 0; i < mf; i++)
+                r[i] += g_[p + i] * w[p + i];
+        }
+        std::complex<float>* frame = out + (f - f0) * m;
+        for (size_t k = 0; k < m_; k++)
+            frame[k] = scratch[m_ - 1 - k];
+        fft_.inverse(frame);
+    }
+    return size_t(f1 - f0);
+}
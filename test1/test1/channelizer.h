@@ -0,0 +1,31 @@
+#pragma once
+
+#include "fft.h"
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ٽĶ˲飨PFBŵΪchannelsŵÿŵĲΪ1/channels
+// ŵkƵΪk/channelsʣk > channels/2ʱΪƵʣ
+// ԭ͵ͨchannels*taps_per_channelףprocess()޸Ķ󣬿ڶ߳й
+class pfb_channelizer
+{
+public:
+    // channels2
+    pfb_channelizer(size_t channels, size_t taps_per_channel);
+
+    size_t channels() const { return m_; }
+    size_t num_taps() const { return g_.size() / 2; }
+
+    // ȫ±t = f*channels[from, to)ڵ֡fÿ֡channels㣨ŵУ
+    // y[i]Ϊȫ±base + i룬븲[һ֡± - (num_taps() - 1), to)
+    // scratchΪchannelsĹ֡*firstΪһ֡f
+    size_t process(const std::complex<float>* y, int64_t base, int64_t from, int64_t to,
+        std::complex<float>* out, std::complex<float>* scratch, int64_t* first) const;
+
+private:
+    size_t m_;
+    std::vector<float> g_;      // ԭϵÿظ
+    fft_plan fft_;
+};
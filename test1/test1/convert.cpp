@@ -0,0 +1,206 @@
+#include "convert.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CONVERT_USE_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const float SC16_SCALE = 1.0f / 32768.0f;
+    const float SC8_SCALE = 1.0f / 128.0f;
+    const float SC16_FULL_SCALE = 32767.0f;
+    const float SC8_FULL_SCALE = 127.0f;
+
+    template <typename T>
+    T saturate(float v, float full_scale)
+    {
+        return T(std::lrint(std::min(std::max(v * full_scale, -full_scale - 1.0f), full_scale)));
+    }
+}
+
+void convert_sc16_to_fc32(const std::complex<int16_t>* in, std::complex<float>* out, size_t nsamps)
+{
+    // int16ÿ
+    const int16_t* src = reinterpret_cast<const int16_t*>(in);
+    float* dst = reinterpret_cast<float*>(out);
+    const size_t n = nsamps * 2;
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256 scale = _mm256_set1_ps(SC16_SCALE);
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(v));
+        __m256i hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(v, 1));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), scale));
+        _mm256_storeu_ps(dst + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), scale));
+    }
+#elif defined(CONVERT_USE_SSE2)
+    const __m128 scale = _mm_set1_ps(SC16_SCALE);
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        // SSE2ûзչָŵ16λ
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; i + 8 <= n; i += 8)
+    {
+        int16x8_t v = vld1q_s16(src + i);
+        float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+        float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+        vst1q_f32(dst + i, vmulq_n_f32(lo, SC16_SCALE));
+        vst1q_f32(dst + i + 4, vmulq_n_f32(hi, SC16_SCALE));
+    }
+#endif
+
+    // ʣ಻һĲ
+    for (; i < n; i++)
+        dst[i] = float(src[i]) * SC16_SCALE;
+}
+
+void convert_sc8_to_fc32(const std::complex<int8_t>* in, std::complex<float>* out, size_t nsamps)
+{
+    const int8_t* src = reinterpret_cast<const int8_t*>(in);
+    float* dst = reinterpret_cast<float*>(out);
+    const size_t n = nsamps * 2;
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    const __m256 scale = _mm256_set1_ps(SC8_SCALE);
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m256i lo = _mm256_cvtepi8_epi32(v);
+        __m256i hi = _mm256_cvtepi8_epi32(_mm_srli_si128(v, 8));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), scale));
+        _mm256_storeu_ps(dst + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), scale));
+    }
+#elif defined(CONVERT_USE_SSE2)
+    const __m128 scale = _mm_set1_ps(SC8_SCALE);
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        // sc16ͬÿֽڸƵ32λֽڣ24λ
+        __m128i w_lo = _mm_unpacklo_epi8(v, v);
+        __m128i w_hi = _mm_unpackhi_epi8(v, v);
+        __m128i d0 = _mm_srai_epi32(_mm_unpacklo_epi16(w_lo, w_lo), 24);
+        __m128i d1 = _mm_srai_epi32(_mm_unpackhi_epi16(w_lo, w_lo), 24);
+        __m128i d2 = _mm_srai_epi32(_mm_unpacklo_epi16(w_hi, w_hi), 24);
+        __m128i d3 = _mm_srai_epi32(_mm_unpackhi_epi16(w_hi, w_hi), 24);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(d0), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(d1), scale));
+        _mm_storeu_ps(dst + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(d2), scale));
+        _mm_storeu_ps(dst + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(d3), scale));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; i + 16 <= n; i += 16)
+    {
+        int8x16_t v = vld1q_s8(src + i);
+        int16x8_t lo = vmovl_s8(vget_low_s8(v));
+        int16x8_t hi = vmovl_s8(vget_high_s8(v));
+        vst1q_f32(dst + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(lo))), SC8_SCALE));
+        vst1q_f32(dst + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(lo))), SC8_SCALE));
+        vst1q_f32(dst + i + 8, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(hi))), SC8_SCALE));
+        vst1q_f32(dst + i + 12, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(hi))), SC8_SCALE));
+    }
+#endif
+
+    for (; i < n; i++)
+        dst[i] = float(src[i]) * SC8_SCALE;
+}
+
+void convert_fc32_to_sc16(const std::complex<float>* in, std::complex<int16_t>* out, size_t nsamps)
+{
+    const float* src = reinterpret_cast<const float*>(in);
+    int16_t* dst = reinterpret_cast<int16_t*>(out);
+    const size_t n = nsamps * 2;
+    size_t i = 0;
+
+    // cvtpsǰģʽĬϾͽȡpacks͵int16
+#if defined(__AVX2__)
+    const __m256 scale = _mm256_set1_ps(SC16_FULL_SCALE);
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256i lo = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src + i), scale));
+        __m256i hi = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src + i + 8), scale));
+        // packs128λͨڷֱٰ64λŻ˳
+        __m256i v = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), v);
+    }
+#elif defined(CONVERT_USE_SSE2)
+    const __m128 scale = _mm_set1_ps(SC16_FULL_SCALE);
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i lo = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i), scale));
+        __m128i hi = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi32(lo, hi));
+    }
+#endif
+
+    for (; i < n; i++)
+        dst[i] = saturate<int16_t>(src[i], SC16_FULL_SCALE);
+}
+
+void convert_fc32_to_sc8(const std::complex<float>* in, std::complex<int8_t>* out, size_t nsamps)
+{
+    const float* src = reinterpret_cast<const float*>(in);
+    int8_t* dst = reinterpret_cast<int8_t*>(out);
+    const size_t n = nsamps * 2;
+    size_t i = 0;
+
+    // packs͵int8
+#if defined(__AVX2__)
+    const __m256 scale = _mm256_set1_ps(SC8_FULL_SCALE);
+    // packs128λͨڴ32λΪa0 b0 c0 d0 | a1 b1 c1 d1Ża0 a1 b0 b1 ...
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i a = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src + i), scale));
+        __m256i b = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src + i + 8), scale));
+        __m256i c = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src + i + 16), scale));
+        __m256i d = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src + i + 24), scale));
+        __m256i v = _mm256_packs_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_permutevar8x32_epi32(v, order));
+    }
+#elif defined(CONVERT_USE_SSE2)
+    const __m128 scale = _mm_set1_ps(SC8_FULL_SCALE);
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i a = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i), scale));
+        __m128i b = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale));
+        __m128i c = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i + 8), scale));
+        __m128i d = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i + 12), scale));
+        __m128i v = _mm_packs_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), v);
+    }
+#endif
+
+    for (; i < n; i++)
+        dst[i] = saturate<int8_t>(src[i], SC8_FULL_SCALE);
+}
+
+const char* convert_impl_name()
+{
+#if defined(__AVX2__)
+    return "avx2";
+#elif defined(CONVERT_USE_SSE2)
+    return "sse2";
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// ʽcpu_formatÿֵֽ֧ĸʽ0
+inline size_t bytes_per_sample(const std::string& cpu_format)
+{
+    if (cpu_format == "fc32")
+        return sizeof(std::complex<float>);
+    if (cpu_format == "sc16")
+        return sizeof(std::complex<int16_t>);
+    if (cpu_format == "sc8")
+        return sizeof(std::complex<int8_t>);
+    return 0;
+}
+
+// sc16 -> fc32[-1, 1)һݱĿѡAVX2/SSE2/NEONʵ
+void convert_sc16_to_fc32(const std::complex<int16_t>* in, std::complex<float>* out, size_t nsamps);
+
+// sc8 -> fc32[-1, 1)һʵֵѡsc16ͬ
+void convert_sc8_to_fc32(const std::complex<int8_t>* in, std::complex<float>* out, size_t nsamps);
+
+// fc32 -> sc161.0Ӧ32767벢͵int16Χ
+void convert_fc32_to_sc16(const std::complex<float>* in, std::complex<int16_t>* out, size_t nsamps);
+
+// fc32 -> sc81.0Ӧ127ͷʽsc16ͬ
+void convert_fc32_to_sc8(const std::complex<float>* in, std::complex<int8_t>* out, size_t nsamps);
+
+// ǰõתʵƣڽ
+const char* convert_impl_name();
@@ -0,0 +1,425 @@
+#include "device_setup.h"
+#include <uhd/types/time_spec.hpp>
+#include <uhd/usrp/subdev_spec.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // һϴ·ʱֵ֮صֵ豸ȡֵֵ֧Ƶʲ浵λ
+    struct coerced_setting
+    {
+        double requested = 0;
+        double actual = 0;
+    };
+    typedef std::map<std::string, coerced_setting> coerced_map;
+
+    // ֻ߳޸ģ߳ڼֻcoerced
+    struct device_cache
+    {
+        uhd::usrp::multi_usrp::sptr usrp;
+        std::string args;
+        std::string synced;     // ϴͬ豸ʱʱġʱԴ/ʱԴ/ͬʽձʾδͬ
+        coerced_map coerced;    // Ϊtx0/freqķͨ
+    };
+    device_cache cache;
+
+    double seconds_since(std::chrono::steady_clock::time_point t)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - t).count();
+    }
+
+    // һɸ̶߳ռ
+    struct mboard_job
+    {
+        size_t mboard = 0;
+        std::vector<size_t> tx_chans;
+        std::vector<size_t> rx_chans;
+        size_t applied = 0;
+        size_t skipped = 0;
+        bool timed = false;
+        uhd::time_spec_t command_time;
+        std::vector<size_t> tx_retuned;
+        std::vector<size_t> rx_retuned;
+        const coerced_map* known = nullptr;     // ỰϸϴεֵͶֵ»ỰΪ
+        std::vector<std::pair<std::string, coerced_setting>> learned;   // ·Ķֵ̲߳뻺
+        std::exception_ptr error;
+
+        // ֵĿtoleranceĿϴͬҶֵϴúĶֵʱ
+        // ǷҪ·
+        bool needs(const std::string& key, double have, double want, double tolerance)
+        {
+            bool same = std::abs(have - want) <= tolerance;
+            if (!same && known != nullptr)
+            {
+                const auto it = known->find(key);
+                same = it != known->end() && it->second.requested == want
+                    && std::abs(have - it->second.actual) <= tolerance;
+            }
+            if (same)
+                skipped++;
+            else
+                applied++;
+            return !same;
+        }
+
+        void learn(const std::string& key, double want, double actual)
+        {
+            learned.emplace_back(key, coerced_setting{want, actual});
+        }
+
+        // Ҫʱ·set()֮get()صֵ
+        void apply(const std::string& key, double want, double tolerance,
+            const std::function<double()>& get, const std::function<void()>& set)
+        {
+            if (!needs(key, get(), want, tolerance))
+                return;
+            set();
+            learn(key, want, get());
+        }
+    };
+
+    std::string setting_key(const char* dir, size_t chan, const char* name)
+    {
+        return std::string(dir) + std::to_string(chan) + "/" + name;
+    }
+
+    // ͨһ豸㣬rx_channel::mboardһ
+    std::vector<mboard_job> make_jobs(uhd::usrp::multi_usrp::sptr usrp, const test_config& cfg)
+    {
+        const size_t num_mboards = usrp->get_num_mboards();
+        std::vector<mboard_job> jobs(num_mboards);
+        for (size_t m = 0; m < num_mboards; m++)
+            jobs[m].mboard = m;
+        const size_t tx_per_mboard = std::max<size_t>(1, usrp->get_tx_subdev_spec(0).size());
+        const size_t rx_per_mboard = std::max<size_t>(1, usrp->get_rx_subdev_spec(0).size());
+        for (size_t chan : cfg.tx_chans)
+            jobs[std::min(chan / tx_per_mboard, num_mboards - 1)].tx_chans.push_back(chan);
+        for (size_t chan : cfg.rx_chans)
+            jobs[std::min(chan / rx_per_mboard, num_mboards - 1)].rx_chans.push_back(chan);
+        return jobs;
+    }
+
+    // ÿһִ߳f(job)ֻһʱֱڵǰִ߳Уһ쳣ȫ׳
+    void for_each_mboard(std::vector<mboard_job>& jobs, const std::function<void(mboard_job&)>& f)
+    {
+        auto run = [&f](mboard_job& job)
+        {
+            try
+            {
+                f(job);
+            }
+            catch (...)
+            {
+                job.error = std::current_exception();
+            }
+        };
+        if (jobs.size() == 1)
+            run(jobs.front());
+        else
+        {
+            std::vector<std::thread> threads;
+            for (auto& job : jobs)
+                threads.emplace_back(run, std::ref(job));
+            for (auto& t : threads)
+                t.join();
+        }
+        for (const auto& job : jobs)
+        {
+            if (job.error)
+                std::rethrow_exception(job.error);
+        }
+    }
+
+    void set_sources(uhd::usrp::multi_usrp::sptr usrp, const test_config& cfg, mboard_job& job)
+    {
+        const size_t m = job.mboard;
+        if (usrp->get_clock_source(m) == cfg.clock_source)
+            job.skipped++;
+        else
+        {
+            usrp->set_clock_source(cfg.clock_source, m);
+            job.applied++;
+        }
+        if (usrp->get_time_source(m) == cfg.time_source)
+            job.skipped++;
+        else
+        {
+            usrp->set_time_source(cfg.time_source, m);
+            job.applied++;
+        }
+    }
+
+    // ʺֱãҪصгƵtimedʱͬһʱ·
+    void tune(uhd::usrp::multi_usrp::sptr usrp, const test_config& cfg, bool timed, mboard_job& job)
+    {
+        const double rate_tol = 1e-6 * cfg.sample_rate;
+        for (size_t chan : job.tx_chans)
+            job.apply(setting_key("tx", chan, "rate"), cfg.sample_rate, rate_tol,
+                [&] { return usrp->get_tx_rate(chan); }, [&] { usrp->set_tx_rate(cfg.sample_rate, chan); });
+        for (size_t chan : job.rx_chans)
+            job.apply(setting_key("rx", chan, "rate"), cfg.sample_rate, rate_tol,
+                [&] { return usrp->get_rx_rate(chan); }, [&] { usrp->set_rx_rate(cfg.sample_rate, chan); });
+
+        // ʱصгʱЧֵread_back_freqsڵȴ֮¼
+        job.tx_retuned.clear();
+        job.rx_retuned.clear();
+        for (size_t chan : job.tx_chans)
+        {
+            if (job.needs(setting_key("tx", chan, "freq"), usrp->get_tx_freq(chan), cfg.center_freq, 1.0))
+                job.tx_retuned.push_back(chan);
+        }
+        for (size_t chan : job.rx_chans)
+        {
+            if (job.needs(setting_key("rx", chan, "freq"), usrp->get_rx_freq(chan), cfg.center_freq, 1.0))
+                job.rx_retuned.push_back(chan);
+        }
+        if (!job.tx_retuned.empty() || !job.rx_retuned.empty())
+        {
+            if (timed)
+            {
+                job.timed = true;
+                job.command_time = usrp->get_time_now(job.mboard) + uhd::time_spec_t(cfg.retune_lead);
+                usrp->set_command_time(job.command_time, job.mboard);
+            }
+            for (size_t chan : job.tx_retuned)
+                usrp->set_tx_freq(uhd::tune_request_t(cfg.center_freq), chan);
+            for (size_t chan : job.rx_retuned)
+                usrp->set_rx_freq(uhd::tune_request_t(cfg.center_freq), chan);
+            if (timed)
+                usrp->clear_command_time(job.mboard);
+        }
+
+        for (size_t chan : job.tx_chans)
+            job.apply(setting_key("tx", chan, "gain"), cfg.tx_gain, 0.01,
+                [&] { return usrp->get_tx_gain(chan); }, [&] { usrp->set_tx_gain(cfg.tx_gain, chan); });
+        for (size_t chan : job.rx_chans)
+            job.apply(setting_key("rx", chan, "gain"), cfg.rx_gain, 0.01,
+                [&] { return usrp->get_rx_gain(chan); }, [&] { usrp->set_rx_gain(cfg.rx_gain, chan); });
+    }
+
+    // ¼صгƵʶֵƵȡ֮ʵƵʣ
+    void read_back_freqs(uhd::usrp::multi_usrp::sptr usrp, const test_config& cfg, mboard_job& job)
+    {
+        for (size_t chan : job.tx_retuned)
+            job.learn(setting_key("tx", chan, "freq"), cfg.center_freq, usrp->get_tx_freq(chan));
+        for (size_t chan : job.rx_retuned)
+            job.learn(setting_key("rx", chan, "freq"), cfg.center_freq, usrp->get_rx_freq(chan));
+    }
+
+    // ȵÿ豸ʱԽʱʱ䣬֮ͬͽŶе
+    void wait_command_time(uhd::usrp::multi_usrp::sptr usrp, const std::vector<mboard_job>& jobs, double lead)
+    {
+        const auto deadline = std::chrono::steady_clock::now()
+            + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(lead + 1.0));
+        for (const auto& job : jobs)
+        {
+            while (job.timed && usrp->get_time_now(job.mboard) < job.command_time)
+            {
+                if (std::chrono::steady_clock::now() > deadline)
+                {
+                    std::cerr << "Warning: mboard " << job.mboard << " device time did not reach the retune time" << std::endl;
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+        }
+    }
+
+    size_t sum_applied(std::vector<mboard_job>& jobs, setup_timings& timings)
+    {
+        size_t applied = 0;
+        for (auto& job : jobs)
+        {
+            applied += job.applied;
+            timings.applied += job.applied;
+            timings.skipped += job.skipped;
+            job.applied = job.skipped = 0;
+        }
+        return applied;
+    }
+}
+
+uhd::device_addr_t make_device_addr(const test_config& cfg)
+{
+    uhd::device_addr_t combined;
+    for (size_t i = 0; i < cfg.devices.size(); i++)
+    {
+        uhd::device_addr_t dev(cfg.devices[i]);
+        // --argsдĲڴ
+        for (const std::string& key : cfg.transport_args.keys())
+        {
+            if (!dev.has_key(key))
+                dev[key] = cfg.transport_args[key];
+        }
+        dev["recv_buff_size"] = std::to_string(cfg.recv_buff_size);
+        dev["num_send_frames"] = std::to_string(cfg.num_send_frames);
+        if (cfg.master_clock_rate > 0)
+            dev["master_clock_rate"] = std::to_string(cfg.master_clock_rate);
+
+        const std::string suffix = (cfg.devices.size() == 1) ? "" : std::to_string(i);
+        for (const std::string& key : dev.keys())
+            combined[key + suffix] = dev[key];
+    }
+    return combined;
+}
+
+uhd::usrp::multi_usrp::sptr open_device(const test_config& cfg, setup_timings* timings)
+{
+    const std::string args = make_device_addr(cfg).to_string();
+    if (cfg.reuse_device && cache.usrp && cache.args == args)
+    {
+        if (timings != nullptr)
+            timings->reused = true;
+        return cache.usrp;
+    }
+
+    release_cached_device();
+    const auto t0 = std::chrono::steady_clock::now();
+    auto usrp = uhd::usrp::multi_usrp::make(uhd::device_addr_t(args));
+    if (timings != nullptr)
+        timings->make = seconds_since(t0);
+    if (cfg.reuse_device)
+    {
+        cache.usrp = usrp;
+        cache.args = args;
+    }
+    return usrp;
+}
+
+void release_cached_device()
+{
+    cache = device_cache();
+}
+
+void configure_device(uhd::usrp::multi_usrp::sptr usrp, const test_config& cfg, setup_timings& timings)
+{
+    // 1. 豸嶼Ǹʱ
+    auto t0 = std::chrono::steady_clock::now();
+    const std::string subdev = uhd::usrp::subdev_spec_t(cfg.subdev).to_string();
+    bool subdev_set = true;
+    for (size_t m = 0; m < usrp->get_num_mboards() && subdev_set; m++)
+        subdev_set = usrp->get_tx_subdev_spec(m).to_string() == subdev && usrp->get_rx_subdev_spec(m).to_string() == subdev;
+    if (subdev_set)
+        timings.skipped += 2;
+    else
+    {
+        usrp->set_tx_subdev_spec(uhd::usrp::subdev_spec_t(cfg.subdev));
+        usrp->set_rx_subdev_spec(uhd::usrp::subdev_spec_t(cfg.subdev));
+        timings.applied += 2;
+    }
+    timings.subdev = seconds_since(t0);
+
+    for (size_t chan : cfg.tx_chans)
+    {
+        if (chan >= usrp->get_tx_num_channels())
+            throw std::runtime_error("Invalid TX channel " + std::to_string(chan));
+    }
+    for (size_t chan : cfg.rx_chans)
+    {
+        if (chan >= usrp->get_rx_num_channels())
+            throw std::runtime_error("Invalid RX channel " + std::to_string(chan));
+    }
+    std::vector<mboard_job> jobs = make_jobs(usrp, cfg);
+    const bool cached = cache.usrp == usrp;
+    for (auto& job : jobs)
+        job.known = cached ? &cache.coerced : nullptr;
+
+    // 2. ʱӺʱԴڵгãյĲο
+    t0 = std::chrono::steady_clock::now();
+    for_each_mboard(jobs, [&](mboard_job& job) { set_sources(usrp, cfg, job); });
+    const bool sources_changed = sum_applied(jobs, timings) > 0;
+    if (cfg.clock_source != "internal")
+        wait_ref_locked(usrp);
+    timings.clock = seconds_since(t0);
+
+    // 3. ƵĻỰ豸ʱһֱЧصгԶʱ
+    t0 = std::chrono::steady_clock::now();
+    const bool timed = timings.reused && cfg.retune_lead > 0;
+    for_each_mboard(jobs, [&](mboard_job& job) { tune(usrp, cfg, timed, job); });
+    wait_command_time(usrp, jobs, cfg.retune_lead);
+    for_each_mboard(jobs, [&](mboard_job& job) { read_back_freqs(usrp, cfg, job); });
+    for (const auto& job : jobs)
+    {
+        timings.timed_retune = timings.timed_retune || job.timed;
+        if (cached)
+        {
+            for (const auto& setting : job.learned)
+                cache.coerced[setting.first] = setting.second;
+        }
+    }
+    sum_applied(jobs, timings);
+    timings.tune = seconds_since(t0);
+
+    // 4. 豸ʱ䣺ĻỰѰͬķʽͬʱͬ
+    t0 = std::chrono::steady_clock::now();
+    const std::string sync_key = cfg.clock_source + "/" + cfg.time_source + "/" + cfg.time_sync;
+    if (cfg.time_sync != "none")
+    {
+        if (timings.reused && !sources_changed && cached && cache.synced == sync_key)
+            timings.skipped++;
+        else
+        {
+            sync_device_time(usrp, cfg);
+            timings.applied++;
+            if (cached)
+                cache.synced = sync_key;
+        }
+    }
+    timings.time_sync = seconds_since(t0);
+    timings.total = timings.make + timings.subdev + timings.clock + timings.tune + timings.time_sync;
+}
+
+void wait_ref_locked(uhd::usrp::multi_usrp::sptr usrp)
+{
+    for (size_t mboard = 0; mboard < usrp->get_num_mboards(); mboard++)
+    {
+        const std::vector<std::string> sensors = usrp->get_mboard_sensor_names(mboard);
+        if (std::find(sensors.begin(), sensors.end(), "ref_locked") == sensors.end())
+            continue;
+        bool locked = false;
+        for (int i = 0; i < 30 && !locked; i++)
+        {
+            locked = usrp->get_mboard_sensor("ref_locked", mboard).to_bool();
+            if (!locked)
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        if (!locked)
+            std::cerr << "Warning: mboard " << mboard << " not locked to the "
+                << usrp->get_clock_source(mboard) << " reference" << std::endl;
+    }
+}
+
+void sync_device_time(uhd::usrp::multi_usrp::sptr usrp, const test_config& cfg)
+{
+    if (cfg.time_sync == "now")
+    {
+        usrp->set_time_now(uhd::time_spec_t(0.0));
+        return;
+    }
+
+    // ȵȵһPPSظչȥ֤һ֮ǰ豸
+    const uhd::time_spec_t last_pps = usrp->get_time_last_pps();
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(1500);
+    while (usrp->get_time_last_pps() == last_pps)
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+            throw std::runtime_error("No PPS detected on time source " + cfg.time_source);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    uhd::time_spec_t next_pps(0.0);
+    if (cfg.time_source == "gpsdo")
+        next_pps = uhd::time_spec_t(double(usrp->get_mboard_sensor("gps_time", 0).to_int() + 1));
+    usrp->set_time_next_pps(next_pps);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "stream_config.h"
+#include <uhd/types/device_addr.hpp>
+#include <uhd/usrp/multi_usrp.hpp>
+#include <cstddef>
+
+// ׶κʱ()·
+struct setup_timings
+{
+    double make = 0;        // multi_usrpϴĻỰʱΪ0
+    double subdev = 0;
+    double tune = 0;        // ʡƵʡ棬岢
+    double clock = 0;       // ʱ/ʱԴȴο
+    double time_sync = 0;
+    double total = 0;
+    size_t applied = 0;     // ʵ·
+    size_t skipped = 0;     // ֵĿ꣨ϴͬһúĶֵһ¶
+    bool reused = false;    // ϴ豸Ự
+    bool timed_retune = false; // ͨʱصг
+};
+
+// ̨豸ϲΪһmulti_usrpÿ豸ļţaddr0=...,addr1=...
+// 㻺ԷRFNoC豸ֻͨ豸ЧΪÿ豸
+uhd::device_addr_t make_device_addr(const test_config& cfg);
+
+// 豸cfg.reuse_device豸ϴͬʱûĻỰɨsppСֻӰĲʱ³ʼ豸
+// ȹرջĻỰٴͬһ豸ͬʱֻһỰ
+uhd::usrp::multi_usrp::sptr open_device(const test_config& cfg, setup_timings* timings = nullptr);
+
+// رջ豸Ự
+void release_cached_device();
+
+// main()ͷз·϶ھ̬֮ǰرջĻỰ
+struct device_cache_scope
+{
+    ~device_cache_scope() { release_cached_device(); }
+};
+
+// 豸ʡƵʡ桢ʱӺʱԴͬ豸ʱ
+// ÿһ̲߳ãͬһͨÿͨ˳·ֵһµ
+// 豸ȡƵʲ浵λõĻỰ϶ֵϴͬһúĶֵʱͬ
+// õĻỰƵʱ仯ʱͬһͨʱڡǰ豸ʱ + cfg.retune_leadͬʱصгȵʱ̹ȥŷ
+// õĻỰʱӡʱԴͬʽδʱͬ豸ʱ
+void configure_device(uhd::usrp::multi_usrp::sptr usrp, const test_config& cfg, setup_timings& timings);
+
+// ȴⲿοⲿ10MHzGPSDOʱֻ
+void wait_ref_locked(uhd::usrp::multi_usrp::sptr usrp);
+
+// 豸ʱ䣺nowֱã豸֮ӳ٣ppsһPPSͬʱЧ
+// GPSDOΪʱԴʱ豸ʱȡGPSʱ䣬0ʼ
+void sync_device_time(uhd::usrp::multi_usrp::sptr usrp, const test_config& cfg);
@@ -0,0 +1,225 @@
+#include "dsp_stage.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+void dsp_stage::sizes(const dsp_params& params, size_t max_block, size_t& history,
+    size_t& in_samps, size_t& dec_samps, size_t& chan_samps)
+{
+    const size_t d = std::max<size_t>(params.decim, 1);
+    const size_t fir_taps = (d > 1) ? fir_decimator(d, params.taps).num_taps() : 0;
+    const size_t m = (params.channels > 1) ? params.channels : 0;
+    const size_t pfb_taps = m * params.channel_taps;
+
+    // ʷ㣺FIRҪǰtaps - 1룻ŵҪǰnum_taps - 1ȡ㣬Ӧ(num_taps - 1)*decim
+    history = ((d > 1) ? fir_taps - 1 : 0) + ((m > 0) ? (pfb_taps - 1) * d : 0);
+    in_samps = history + max_block;
+    dec_samps = (d > 1) ? (max_block / d + ((m > 0) ? pfb_taps : 0) + 2) : 0;
+    chan_samps = (m > 0) ? (max_block / d / m + 2) * m : 0;
+}
+
+size_t dsp_stage::arena_bytes(const dsp_params& params, size_t max_block)
+{
+    size_t history, in_samps, dec_samps, chan_samps;
+    sizes(params, max_block, history, in_samps, dec_samps, chan_samps);
+    const size_t s = sizeof(std::complex<float>);
+    size_t job = buffer_arena::footprint(in_samps * s);
+    if (dec_samps > 0)
+        job += buffer_arena::footprint(dec_samps * s);
+    if (chan_samps > 0)
+        job += buffer_arena::footprint(chan_samps * s);
+    const size_t scratch = (params.channels > 1) ? buffer_arena::footprint(params.channels * s) : 0;
+    return params.threads * (JOBS_PER_THREAD * job + scratch);
+}
+
+dsp_stage::dsp_stage(const dsp_params& params, size_t max_block, buffer_arena& arena, const thread_placement& placement)
+    : params_(params), jobs_(params.threads * JOBS_PER_THREAD)
+{
+    if (params_.threads == 0)
+        throw std::invalid_argument("DSP stage needs at least one worker thread");
+    if (params_.decim > 1)
+        fir_.reset(new fir_decimator(params_.decim, params_.taps));
+    if (params_.channels > 1)
+        channelizer_.reset(new pfb_channelizer(params_.channels, params_.channel_taps));
+
+    size_t in_samps, dec_samps, chan_samps;
+    sizes(params_, max_block, history_, in_samps, dec_samps, chan_samps);
+    hist_.assign(history_, std::complex<float>());
+
+    const size_t s = sizeof(std::complex<float>);
+    for (job& j : jobs_)
+    {
+        j.in = static_cast<std::complex<float>*>(arena.allocate(in_samps * s));
+        if (dec_samps > 0)
+            j.dec = static_cast<std::complex<float>*>(arena.allocate(dec_samps * s));
+        if (chan_samps > 0)
+            j.chan = static_cast<std::complex<float>*>(arena.allocate(chan_samps * s));
+    }
+    scratch_.resize(params_.threads);
+    if (channelizer_)
+    {
+        for (auto& p : scratch_)
+            p = static_cast<std::complex<float>*>(arena.allocate(params_.channels * s));
+    }
+    metrics_.reset(new dsp_metrics[params_.threads]);
+
+    // ÿжܷȫsubmit()ʧ
+    pool_.reset(new work_pool(params_.threads, jobs_.size(),
+        [this](size_t worker, void* task) { process(worker, *static_cast<job*>(task)); }, placement));
+}
+
+dsp_stage::~dsp_stage()
+{
+    if (!finished_)
+        finish();
+}
+
+void dsp_stage::submit(const std::complex<float>* data, size_t nsamps, int64_t index)
+{
+    if (started_ && index != next_index_)
+    {
+        ++gaps;
+        std::fill(hist_.begin(), hist_.end(), std::complex<float>());
+    }
+    started_ = true;
+    next_index_ = index + int64_t(nsamps);
+
+    // ţ尴ѭʹãǰȰһֵĽ
+    job& j = jobs_[seq_ % jobs_.size()];
+    if (j.used)
+    {
+        if (!j.done.load(std::memory_order_acquire))
+        {
+            ++stalls;
+            while (!j.done.load(std::memory_order_acquire))
+                std::this_thread::yield();
+        }
+        emit(j);
+    }
+
+    // ״̬ʷǰһĩβhistory_
+    std::copy(hist_.begin(), hist_.end(), j.in);
+    std::memcpy(j.in + history_, data, nsamps * sizeof(std::complex<float>));
+    j.seq = seq_;
+    j.base = index - int64_t(history_);
+    j.from = index;
+    j.to = next_index_;
+    j.used = true;
+    j.done.store(false, std::memory_order_relaxed);
+
+    if (nsamps >= history_)
+    {
+        std::copy(data + (nsamps - history_), data + nsamps, hist_.begin());
+    }
+    else
+    {
+        std::copy(hist_.begin() + nsamps, hist_.end(), hist_.begin());
+        std::copy(data, data + nsamps, hist_.end() - nsamps);
+    }
+
+    pool_->submit(&j, size_t(seq_));
+    seq_++;
+}
+
+void dsp_stage::process(size_t worker, job& j)
+{
+    using clock = std::chrono::steady_clock;
+    dsp_metrics& m = metrics_[worker];
+    const int64_t d = int64_t(params_.decim);
+    const std::complex<float>* y = j.in;
+    int64_t y_base = j.base;
+    int64_t from = j.from;
+    int64_t to = j.to;
+
+    if (fir_)
+    {
+        // ŵҪĳȡʷҲһ
+        const int64_t ext = channelizer_ ? int64_t(channelizer_->num_taps() - 1) * d : 0;
+        const auto t0 = clock::now();
+        int64_t first = 0;
+        const size_t n = fir_->filter(j.in, j.base, j.from - ext, j.to, j.dec, &first);
+        m.fir_ns += uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - t0).count());
+        y = j.dec;
+        y_base = first;
+        from = ceil_div(j.from, d);
+        to = ceil_div(j.to, d);
+        j.out_samps = size_t(std::min<int64_t>(int64_t(n), to - from));
+        j.out = j.dec + (n - j.out_samps);
+        j.out_index = from;
+    }
+    else
+    {
+        j.out_samps = size_t(to - from);
+        j.out = j.in + history_;
+        j.out_index = from;
+    }
+    m.out_samples += j.out_samps;
+
+    if (channelizer_)
+    {
+        const auto t0 = clock::now();
+        int64_t first = 0;
+        const size_t frames = channelizer_->process(y, y_base, from, to, j.chan, scratch_[worker], &first);
+        m.channel_ns += uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - t0).count());
+        m.channel_frames += frames;
+        j.out = j.chan;
+        j.out_samps = frames * params_.channels;
+        j.out_index = first * int64_t(params_.channels);
+    }
+
+    m.in_samples += uint64_t(j.to - j.from);
+    ++m.blocks;
+
+    // ¼ɵţСĿɵʱҪŻָ˳
+    const uint64_t mark = j.seq + 1;
+    uint64_t newest = newest_done_.load(std::memory_order_relaxed);
+    while (mark > newest && !newest_done_.compare_exchange_weak(newest, mark, std::memory_order_relaxed))
+    {
+    }
+    if (mark < newest)
+        ++m.reordered;
+    j.done.store(true, std::memory_order_release);
+}
+
+void dsp_stage::emit(job& j)
+{
+    if (output_ && j.out_samps > 0)
+        output_(j.out, j.out_samps, j.out_index);
+    emitted_samples += j.out_samps;
+    j.used = false;
+}
+
+void dsp_stage::finish()
+{
+    finished_ = true;
+    pool_->finish();
+    // ʣſʼ
+    const size_t n = jobs_.size();
+    for (size_t i = 0; i < n; i++)
+    {
+        job& j = jobs_[(seq_ + i) % n];
+        if (j.used)
+            emit(j);
+    }
+}
+
+dsp_totals dsp_stage::totals() const
+{
+    dsp_totals t;
+    for (size_t i = 0; i < params_.threads; i++)
+    {
+        const dsp_metrics& m = metrics_[i];
+        t.blocks += m.blocks;
+        t.in_samples += m.in_samples;
+        t.out_samples += m.out_samples;
+        t.channel_frames += m.channel_frames;
+        t.fir_ns += m.fir_ns;
+        t.channel_ns += m.channel_ns;
+        t.reordered += m.reordered;
+        t.steals += pool_->metrics(i).steals;
+        t.busy_ns += pool_->metrics(i).busy_ns;
+    }
+    return t;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "buffer_arena.h"
+#include "channelizer.h"
+#include "fir.h"
+#include "metrics.h"
+#include "thread_placement.h"
+#include "work_pool.h"
+#include <atomic>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// պDSP
+struct dsp_params
+{
+    size_t decim = 1;               // FIRȡ1ʾȡ
+    size_t taps = 0;                // FIR0ʾ8*decim
+    size_t channels = 0;            // ȡPFBŵ2ݣ01ʾŵ
+    size_t channel_taps = 8;        // ŵԭ˲ÿŵĽ
+    size_t threads = 2;             // ߳
+
+    bool enabled() const { return decim > 1 || channels > 1; }
+};
+
+// ÿ̵߳ļֻɸ߳д
+struct alignas(CACHE_LINE_SIZE) dsp_metrics
+{
+    counter blocks;
+    counter in_samples;             // ̸߳㣨ʷ㣩
+    counter out_samples;            // ȡ
+    counter channel_frames;         // ŵ֡ÿ֡ÿŵһ
+    counter fir_ns;                 // FIRȡʱ
+    counter channel_ns;             // ŵʱ
+    counter reordered;              // ŸĿɡҪŵĿ
+};
+
+// й̵߳ļ֮
+struct dsp_totals
+{
+    uint64_t blocks = 0;
+    uint64_t in_samples = 0;
+    uint64_t out_samples = 0;
+    uint64_t channel_frames = 0;
+    uint64_t fir_ns = 0;
+    uint64_t channel_ns = 0;
+    uint64_t reordered = 0;
+    uint64_t steals = 0;            // ̳߳ȡ
+    uint64_t busy_ns = 0;           // ִ̳߳ܺʱ
+};
+
+// ջζ֮DSPFIRȡѡPFBŵ
+// ߣ̣߳˳ύfc32飬ÿΪ񽻸ȡ̳߳زд
+// ÿͬǰʷһ𽻳֮߳û˲״̬δ˲ͬ
+// 񻺳尴ѭʹãһǰȵɲѽصϸ
+// Ŀ黹ûʱsubmit()ȴѹջζ
+class dsp_stage
+{
+public:
+    static constexpr size_t JOBS_PER_THREAD = 4;
+
+    // ȡ㣬ŵ֡ÿ֡channels㣬ŵУ
+    // indexΪһȫ±꣨ŵʱΪ֡ * channels
+    typedef std::function<void(const std::complex<float>* data, size_t nsamps, int64_t index)> output_fn;
+
+    // arenaз䣬arenaԤarena_bytes()max_blockΪһύ
+    dsp_stage(const dsp_params& params, size_t max_block, buffer_arena& arena, const thread_placement& placement);
+    ~dsp_stage();
+
+    dsp_stage(const dsp_stage&) = delete;
+    dsp_stage& operator=(const dsp_stage&) = delete;
+
+    static size_t arena_bytes(const dsp_params& params, size_t max_block);
+
+    // ðصڵsubmit()/finish()ִ߳Уڵһsubmit()֮ǰ
+    void set_output(output_fn fn) { output_ = std::move(fn); }
+
+    // ύnsamps㣬indexΪһȫ±ꣻʱʷ¿ʼ
+    // ֻһ̵߳
+    void submit(const std::complex<float>* data, size_t nsamps, int64_t index);
+
+    // ȴύĿ鴦ꡢʣֹ̣ͣ߳submit()߳̽
+    void finish();
+
+    const dsp_params& params() const { return params_; }
+    const fir_decimator* fir() const { return fir_.get(); }
+    const pfb_channelizer* channelizer() const { return channelizer_.get(); }
+    size_t history() const { return history_; }
+
+    dsp_totals totals() const;
+
+    alignas(CACHE_LINE_SIZE) counter stalls; // ߵȴĿɵĴ
+    counter gaps;                             // 벻Ĵ
+    counter emitted_samples;                  // 򽻸ص
+
+private:
+    struct job
+    {
+        std::complex<float>* in = nullptr;      // ʷ + 
+        std::complex<float>* dec = nullptr;     // ȡΪŵʷ
+        std::complex<float>* chan = nullptr;    // ŵ
+        uint64_t seq = 0;                       // 
+        int64_t base = 0;                       // in[0]ȫ±
+        int64_t from = 0;                       // 鸺±귶Χ[from, to)
+        int64_t to = 0;
+        const std::complex<float>* out = nullptr; // ±꣬߳д
+        size_t out_samps = 0;
+        int64_t out_index = 0;
+        bool used = false;                      // ύδ
+        std::atomic<bool> done{ false };
+    };
+
+    static void sizes(const dsp_params& params, size_t max_block, size_t& history,
+        size_t& in_samps, size_t& dec_samps, size_t& chan_samps);
+
+    void process(size_t worker, job& j);
+    void emit(job& j);
+
+    const dsp_params params_;
+    std::unique_ptr<fir_decimator> fir_;
+    std::unique_ptr<pfb_channelizer> channelizer_;
+    size_t history_ = 0;
+    std::vector<job> jobs_;
+    std::vector<std::complex<float>*> scratch_;  // ÿ̵߳ŵ
+    std::unique_ptr<dsp_metrics[]> metrics_;
+    std::vector<std::complex<float>> hist_;     // ߱history_
+    int64_t next_index_ = 0;
+    bool started_ = false;
+    uint64_t seq_ = 0;
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> newest_done_{ 0 }; // ɵ + 1
+    output_fn output_;
+    std::unique_ptr<work_pool> pool_;
+    bool finished_ = false;
+};
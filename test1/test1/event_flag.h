@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+// ɵȴı־set()еȴ桰־ + sleepѯ
+// is_set()ֻһԭӶȡԷȵѭУset()͵ȴҪֹֻͣʱõ
+// set()źŴе
+class event_flag
+{
+public:
+    event_flag() = default;
+    event_flag(const event_flag&) = delete;
+    event_flag& operator=(const event_flag&) = delete;
+
+    void set()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            flag_.store(true, std::memory_order_release);
+        }
+        cv_.notify_all();
+    }
+
+    void reset()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        flag_.store(false, std::memory_order_release);
+    }
+
+    bool is_set() const { return flag_.load(std::memory_order_acquire); }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return is_set(); });
+    }
+
+    // Ƿset()
+    template <typename Rep, typename Period>
+    bool wait_for(const std::chrono::duration<Rep, Period>& timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_for(lock, timeout, [this] { return is_set(); });
+    }
+
+    template <typename Clock, typename Duration>
+    bool wait_until(const std::chrono::time_point<Clock, Duration>& deadline)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return cv_.wait_until(lock, deadline, [this] { return is_set(); });
+    }
+
+private:
+    std::atomic<bool> flag_{ false };
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
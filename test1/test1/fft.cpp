@@ -0,0 +1,65 @@
+#include "fft.h"
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+fft_plan::fft_plan(size_t n) : n_(n)
+{
+    if (n < 2 || (n & (n - 1)) != 0)
+        throw std::invalid_argument("FFT size must be a power of two");
+
+    size_t bits = 0;
+    while ((size_t(1) << bits) < n)
+        bits++;
+    bitrev_.resize(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        size_t r = 0;
+        for (size_t b = 0; b < bits; b++)
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        bitrev_[i] = r;
+    }
+
+    const double pi = std::acos(-1.0);
+    twiddles_.resize(n / 2);
+    for (size_t k = 0; k < n / 2; k++)
+        twiddles_[k] = std::complex<float>(std::polar(1.0, -2.0 * pi * double(k) / double(n)));
+}
+
+void fft_plan::transform(std::complex<float>* data, bool inverse) const
+{
+    for (size_t i = 0; i < n_; i++)
+    {
+        if (i < bitrev_[i])
+            std::swap(data[i], data[bitrev_[i]]);
+    }
+
+    // ÿһεĿΪlenתڱеĲΪn/len
+    // д˷std::complex˷ΪNaN/Infɵ·
+    // ʵ鲿floatֿдGCC-O3»ѸɵЧĻϴ
+    float* d = reinterpret_cast<float*>(data);
+    const float sign = inverse ? -1.0f : 1.0f;
+    for (size_t len = 2; len <= n_; len <<= 1)
+    {
+        const size_t half = len / 2;
+        const size_t step = n_ / len;
+        for (size_t base = 0; base < n_; base += len)
+        {
+            float* a = d + 2 * base;
+            float* b = a + 2 * half;
+            for (size_t k = 0; k < half; k++)
+            {
+                const float wr = twiddles_[k * step].real();
+                const float wi = sign * twiddles_[k * step].imag();
+                const float xr = b[2 * k], xi = b[2 * k + 1];
+                const float tr = wr * xr - wi * xi;
+                const float ti = wr * xi + wi * xr;
+                const float ar = a[2 * k], ai = a[2 * k + 1];
+                b[2 * k] = ar - tr;
+                b[2 * k + 1] = ai - ti;
+                a[2 * k] = ar + tr;
+                a[2 * k + 1] = ai + ti;
+            }
+        }
+    }
+}
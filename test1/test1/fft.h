@@ -0,0 +1,28 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+// 2FFTȱ2
+// תӺλתڹʱԤȼ㣬任ڴ棬ڶ߳й
+class fft_plan
+{
+public:
+    explicit fft_plan(size_t n);
+
+    size_t size() const { return n_; }
+
+    // ԭ任
+    void forward(std::complex<float>* data) const { transform(data, false); }
+
+    // ԭ任1/Nһ
+    void inverse(std::complex<float>* data) const { transform(data, true); }
+
+private:
+    void transform(std::complex<float>* data, bool inverse) const;
+
+    size_t n_;
+    std::vector<size_t> bitrev_;
+    std::vector<std::complex<float>> twiddles_; // exp(-2*pi*i*k/n)k < n/2
+};
@@ -0,0 +1,140 @@
+#include "fir.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FIR_USE_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+    // һ㣺hhxnffloatżλΪʵλΪ鲿nf8ı
+    inline std::complex<float> dot(const float* hh, const float* x, size_t nf)
+    {
+#if defined(__AVX2__)
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        size_t i = 0;
+        for (; i + 16 <= nf; i += 16)
+        {
+#if defined(__FMA__)
+            acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(hh + i), _mm256_loadu_ps(x + i), acc0);
+            acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(hh + i + 8), _mm256_loadu_ps(x + i + 8), acc1);
+#else
+            acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(hh + i), _mm256_loadu_ps(x + i)));
+            acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(hh + i + 8), _mm256_loadu_ps(x + i + 8)));
+#endif
+        }
+        if (i < nf)
+            acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(hh + i), _mm256_loadu_ps(x + i)));
+        acc0 = _mm256_add_ps(acc0, acc1);
+        __m128 s = _mm_add_ps(_mm256_castps256_ps128(acc0), _mm256_extractf128_ps(acc0, 1));
+        s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+        return std::complex<float>(_mm_cvtss_f32(s), _mm_cvtss_f32(_mm_shuffle_ps(s, s, 1)));
+#elif defined(FIR_USE_SSE2)
+        __m128 acc0 = _mm_setzero_ps();
+        __m128 acc1 = _mm_setzero_ps();
+        for (size_t i = 0; i < nf; i += 8)
+        {
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(hh + i), _mm_loadu_ps(x + i)));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(hh + i + 4), _mm_loadu_ps(x + i + 4)));
+        }
+        __m128 s = _mm_add_ps(acc0, acc1);
+        s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+        return std::complex<float>(_mm_cvtss_f32(s), _mm_cvtss_f32(_mm_shuffle_ps(s, s, 1)));
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+        float32x4_t acc0 = vdupq_n_f32(0.0f);
+        float32x4_t acc1 = vdupq_n_f32(0.0f);
+        for (size_t i = 0; i < nf; i += 8)
+        {
+            acc0 = vmlaq_f32(acc0, vld1q_f32(hh + i), vld1q_f32(x + i));
+            acc1 = vmlaq_f32(acc1, vld1q_f32(hh + i + 4), vld1q_f32(x + i + 4));
+        }
+        const float32x4_t s = vaddq_f32(acc0, acc1);
+        const float32x2_t p = vadd_f32(vget_low_f32(s), vget_high_f32(s));
+        return std::complex<float>(vget_lane_f32(p, 0), vget_lane_f32(p, 1));
+#else
+        float re = 0, im = 0;
+        for (size_t i = 0; i < nf; i += 2)
+        {
+            re += hh[i] * x[i];
+            im += hh[i + 1] * x[i + 1];
+        }
+        return std::complex<float>(re, im);
+#endif
+    }
+}
+
+std::vector<float> design_lowpass(size_t taps, double cutoff)
+{
+    const double pi = std::acos(-1.0);
+    std::vector<float> h(taps);
+    double sum = 0;
+    for (size_t i = 0; i < taps; i++)
+    {
+        const double t = double(i) - double(taps - 1) / 2;
+        const double sinc = (t == 0) ? 2 * cutoff : std::sin(2 * pi * cutoff * t) / (pi * t);
+        const double w = (taps == 1) ? 1.0 : 0.42 - 0.5 * std::cos(2 * pi * double(i) / double(taps - 1))
+            + 0.08 * std::cos(4 * pi * double(i) / double(taps - 1));
+        h[i] = float(sinc * w);
+        sum += sinc * w;
+    }
+    for (float& v : h)
+        v = float(v / sum);
+    return h;
+}
+
+fir_decimator::fir_decimator(size_t decim, size_t taps)
+    : decim_(decim), taps_((taps == 0) ? 8 * decim : taps)
+{
+    if (decim_ == 0)
+        throw std::invalid_argument("FIR decimation must be at least 1");
+    taps_ = (taps_ + 3) / 4 * 4;
+    // ֹƵȡȡο˹Ƶʵ0.9ɴ
+    const std::vector<float> h = design_lowpass(taps_, 0.45 / double(decim_));
+    hh_.resize(2 * taps_);
+    for (size_t k = 0; k < taps_; k++)
+        hh_[2 * k] = hh_[2 * k + 1] = h[taps_ - 1 - k];
+}
+
+size_t fir_decimator::filter(const std::complex<float>* x, int64_t base, int64_t from, int64_t to,
+    std::complex<float>* out, int64_t* first) const
+{
+    const int64_t d = int64_t(decim_);
+    const int64_t j0 = ceil_div(from, d);
+    const int64_t j1 = ceil_div(to, d);
+    *first = j0;
+    if (j1 <= j0)
+        return 0;
+
+    // y[j] = sum(h[k] * x[j*decim - k])ϵx[j*decim - taps + 1 ...]
+    const float* xf = reinterpret_cast<const float*>(x);
+    const size_t nf = 2 * taps_;
+    for (int64_t j = j0; j < j1; j++)
+    {
+        const int64_t start = j * d - int64_t(taps_) + 1 - base;
+        out[j - j0] = dot(hh_.data(), xf + 2 * start, nf);
+    }
+    return size_t(j1 - j0);
+}
+
+const char* fir_impl_name()
+{
+#if defined(__AVX2__) && defined(__FMA__)
+    return "avx2+fma";
+#elif defined(__AVX2__)
+    return "avx2";
+#elif defined(FIR_USE_SSE2)
+    return "sse2";
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// BlackmansincͨcutoffΪԲʵĽֹƵ(0~0.5)ϵ֮͹һΪ1
+std::vector<float> design_lowpass(size_t taps, double cutoff);
+
+// ȡ±Ϊʷʼ֮ǰ
+inline int64_t ceil_div(int64_t a, int64_t b)
+{
+    return (a >= 0) ? (a + b - 1) / b : -((-a) / b);
+}
+
+// FIRȡֻ㱣㣨ÿdecimһȼ˲ٳȡ
+// ϵڹʱƺãfilter()޸Ķ󣬿ڶ߳йãĿѡAVX2/SSE2/NEONʵ
+class fir_decimator
+{
+public:
+    // tapsΪ0ʱȡ8*decimʵʽȡ4ı
+    fir_decimator(size_t decim, size_t taps);
+
+    size_t decim() const { return decim_; }
+    size_t num_taps() const { return taps_; }
+
+    // ȫ±n = j*decim[from, to)ڵy[j]x[i]Ϊȫ±base + i
+    // x븲[һ± - (taps - 1), to)*firstΪһ±j
+    size_t filter(const std::complex<float>* x, int64_t base, int64_t from, int64_t to,
+        std::complex<float>* out, int64_t* first) const;
+
+private:
+    size_t decim_;
+    size_t taps_;
+    std::vector<float> hh_;     // ϵÿظΣֱʵ鲿
+};
+
+// ǰõFIRʵ
+const char* fir_impl_name();
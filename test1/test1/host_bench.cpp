@@ -0,0 +1,396 @@
+// ȵ·߻׼ԣҪ豸
+// ζСʽתźŷд̣߳Լģշշ߳
+// CIпԷܻˣƵʹֿ
+#include "buffer_arena.h"
+#include "channelizer.h"
+#include "convert.h"
+#include "dsp_stage.h"
+#include "fir.h"
+#include "latency_histogram.h"
+#include "metrics.h"
+#include "mock_streamer.h"
+#include "psd_monitor.h"
+#include "recorder.h"
+#include "rx_stream.h"
+#include "signal_gen.h"
+#include "spsc_ring.h"
+#include "stream_config.h"
+#include "tx_stream.h"
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <chrono>
+#include <complex>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    const double RATE = 1e6;                        // ģʣֻӰʱ
+    const size_t PIPELINE_SAMPS = size_t(1) << 22;  // շ߳ÿֵ
+
+    std::vector<char> make_signal(const std::string& cpu_format, size_t nsamps)
+    {
+        signal_params params;
+        params.kind = "noise";
+        signal_generator gen(params, RATE, 1);
+        std::vector<char> out(nsamps * bytes_per_sample(cpu_format));
+        gen.generate(out.data(), nsamps, cpu_format);
+        return out;
+    }
+
+    // ȴﵽĿֵշ߳һ߳
+    void wait_for(const counter& c, uint64_t target)
+    {
+        while (c.get() < target)
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+// ߳acquire/publish/front/popֻбָ
+void BM_ring_push_pop(benchmark::State& state)
+{
+    spsc_ring<uint64_t> ring(64);
+    uint64_t n = 0;
+    for (auto _ : state)
+    {
+        *ring.acquire() = n++;
+        ring.publish();
+        benchmark::DoNotOptimize(*ring.front());
+        ring.pop();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ring_push_pop);
+
+// ߺ߸һ̣߳˴ݵ֮أ
+void BM_ring_threads(benchmark::State& state)
+{
+    const size_t items = size_t(1) << 20;
+    spsc_ring<uint64_t> ring(size_t(state.range(0)));
+    for (auto _ : state)
+    {
+        std::thread consumer([&]
+        {
+            for (size_t i = 0; i < items; )
+            {
+                const uint64_t* v = ring.front();
+                if (v == nullptr)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                benchmark::DoNotOptimize(*v);
+                ring.pop();
+                i++;
+            }
+        });
+        for (size_t i = 0; i < items; )
+        {
+            uint64_t* slot = ring.acquire();
+            if (slot == nullptr)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            *slot = i++;
+            ring.publish();
+        }
+        consumer.join();
+    }
+    state.SetItemsProcessed(int64_t(state.iterations() * items));
+}
+BENCHMARK(BM_ring_threads)->Arg(64)->Arg(1024)->UseRealTime();
+
+template <typename In, typename Out, void (*Convert)(const In*, Out*, size_t)>
+void BM_convert(benchmark::State& state)
+{
+    const size_t n = size_t(state.range(0));
+    std::vector<In> in(n);
+    std::vector<Out> out(n);
+    for (size_t i = 0; i < n; i++)
+        in[i] = In(typename In::value_type(i % 100), typename In::value_type(-int(i % 100)));
+    for (auto _ : state)
+    {
+        Convert(in.data(), out.data(), n);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(int64_t(state.iterations() * n));
+    state.SetBytesProcessed(int64_t(state.iterations() * n * sizeof(In)));
+    state.SetLabel(convert_impl_name());
+}
+BENCHMARK_TEMPLATE(BM_convert, std::complex<int16_t>, std::complex<float>, convert_sc16_to_fc32)->Arg(4096)->Arg(65536);
+BENCHMARK_TEMPLATE(BM_convert, std::complex<int8_t>, std::complex<float>, convert_sc8_to_fc32)->Arg(4096)->Arg(65536);
+BENCHMARK_TEMPLATE(BM_convert, std::complex<float>, std::complex<int16_t>, convert_fc32_to_sc16)->Arg(4096)->Arg(65536);
+BENCHMARK_TEMPLATE(BM_convert, std::complex<float>, std::complex<int8_t>, convert_fc32_to_sc8)->Arg(4096)->Arg(65536);
+
+void BM_signal(benchmark::State& state, const char* kind, const char* cpu_format)
+{
+    const size_t n = 4096;
+    signal_params params;
+    params.kind = kind;
+    signal_generator gen(params, RATE, 1);
+    std::vector<char> out(n * bytes_per_sample(cpu_format));
+    for (auto _ : state)
+    {
+        gen.generate(out.data(), n, cpu_format);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(int64_t(state.iterations() * n));
+    state.SetLabel(signal_impl_name());
+}
+BENCHMARK_CAPTURE(BM_signal, qpsk, "qpsk", "fc32");
+BENCHMARK_CAPTURE(BM_signal, qam256, "qam256", "fc32");
+BENCHMARK_CAPTURE(BM_signal, tone, "tone", "fc32");
+BENCHMARK_CAPTURE(BM_signal, chirp, "chirp", "fc32");
+BENCHMARK_CAPTURE(BM_signal, pn, "pn", "fc32");
+BENCHMARK_CAPTURE(BM_signal, noise, "noise", "fc32");
+BENCHMARK_CAPTURE(BM_signal, qpsk_sc16, "qpsk", "sc16");
+BENCHMARK_CAPTURE(BM_signal, noise_sc16, "noise", "sc16");
+
+// FIRȡΪȡȡĬϵ8*decim
+void BM_fir_decimate(benchmark::State& state)
+{
+    const size_t decim = size_t(state.range(0));
+    const size_t n = 65536;
+    const fir_decimator fir(decim, 0);
+    const size_t history = fir.num_taps() - 1;
+    std::vector<std::complex<float>> in(history + n);
+    for (size_t i = 0; i < in.size(); i++)
+        in[i] = std::complex<float>(float(i % 100) / 100, -float(i % 37) / 37);
+    std::vector<std::complex<float>> out(n / decim + 1);
+    int64_t first = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(fir.filter(in.data(), -int64_t(history), 0, int64_t(n), out.data(), &first));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(int64_t(state.iterations() * n));
+    state.SetLabel(fir_impl_name());
+}
+BENCHMARK(BM_fir_decimate)->Arg(2)->Arg(8)->Arg(32);
+
+// PFBŵΪŵÿŵ8
+void BM_channelizer(benchmark::State& state)
+{
+    const size_t channels = size_t(state.range(0));
+    const size_t n = 65536;
+    const pfb_channelizer pfb(channels, 8);
+    const size_t history = pfb.num_taps() - 1;
+    std::vector<std::complex<float>> in(history + n);
+    for (size_t i = 0; i < in.size(); i++)
+        in[i] = std::complex<float>(float(i % 100) / 100, -float(i % 37) / 37);
+    std::vector<std::complex<float>> out(n + channels), scratch(channels);
+    int64_t first = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(pfb.process(in.data(), -int64_t(history), 0, int64_t(n), out.data(), scratch.data(), &first));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(int64_t(state.iterations() * n));
+}
+BENCHMARK(BM_channelizer)->Arg(8)->Arg(64)->Arg(512);
+
+// DSP壺ȡ816ŵΪ߳˻Ͽɿչ
+void BM_dsp_stage(benchmark::State& state)
+{
+    dsp_params params;
+    params.decim = 8;
+    params.channels = 16;
+    params.threads = size_t(state.range(0));
+    const size_t n = 16384;
+    std::vector<std::complex<float>> block(n);
+    for (size_t i = 0; i < n; i++)
+        block[i] = std::complex<float>(float(i % 100) / 100, -float(i % 37) / 37);
+    buffer_arena arena(dsp_stage::arena_bytes(params, n), false);
+    dsp_totals totals;
+    {
+        dsp_stage stage(params, n, arena, thread_placement());
+        int64_t index = 0;
+        for (auto _ : state)
+        {
+            stage.submit(block.data(), n, index);
+            index += int64_t(n);
+        }
+        stage.finish();
+        totals = stage.totals();
+    }
+    state.SetItemsProcessed(int64_t(state.iterations() * n));
+    state.counters["steals"] = double(totals.steals);
+    state.counters["reordered"] = double(totals.reordered);
+}
+BENCHMARK(BM_dsp_stage)->ArgName("threads")->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+// Ƶ׼ӣΪÿFFT֡0ʾ֡RATEĲ֡
+void BM_psd_monitor(benchmark::State& state)
+{
+    psd_params params;
+    params.fft_size = 1024;
+    params.frames_per_sec = double(state.range(0));
+    const size_t n = 16384;
+    const std::vector<char> block = make_signal("fc32", n);
+    psd_monitor psd(params, RATE);
+    int64_t index = 0;
+    for (auto _ : state)
+    {
+        psd.process(reinterpret_cast<const std::complex<float>*>(block.data()), n, index);
+        index += int64_t(n);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations() * n));
+}
+BENCHMARK(BM_psd_monitor)->ArgName("frames_per_sec")->Arg(200)->Arg(0);
+
+// д߼relaxed load+storelockǰ׺fetch_addԱ
+void BM_counter_add(benchmark::State& state)
+{
+    counter c;
+    for (auto _ : state)
+        c += 1;
+    benchmark::DoNotOptimize(c.get());
+}
+BENCHMARK(BM_counter_add);
+
+void BM_atomic_fetch_add(benchmark::State& state)
+{
+    std::atomic<uint64_t> c{ 0 };
+    for (auto _ : state)
+        c.fetch_add(1, std::memory_order_relaxed);
+    benchmark::DoNotOptimize(c.load());
+}
+BENCHMARK(BM_atomic_fetch_add);
+
+void BM_latency_record(benchmark::State& state)
+{
+    latency_histogram hist;
+    uint64_t v = 1000;
+    for (auto _ : state)
+    {
+        hist.record(v);
+        v = v * 1103515245 + 12345;
+        v &= 0xFFFFF;
+    }
+    benchmark::DoNotOptimize(hist.count());
+}
+BENCHMARK(BM_latency_record);
+
+// д̣߳ÿε׷һsc16㣬ȴлʱ䣻ļдڵǰĿ¼
+void BM_recorder(benchmark::State& state)
+{
+    const size_t n = size_t(state.range(0));
+    const std::vector<char> block = make_signal("sc16", n);
+    const std::string base = "host_bench_recording";
+    buffer_arena arena(recorder::arena_bytes(), false);
+    sigmf_info info;
+    info.cpu_format = "sc16";
+    info.sample_rate = RATE;
+    info.hw = "host_bench";
+    bool direct = false;
+    uint64_t stalls = 0;
+    {
+        recorder rec(base, info, arena, thread_placement());
+        int64_t index = 0;
+        for (auto _ : state)
+        {
+            rec.write(block.data(), n, index);
+            index += int64_t(n);
+        }
+        rec.finish();
+        direct = rec.direct_io();
+        stalls = rec.stalls;
+    }
+    std::remove((base + ".sigmf-data").c_str());
+    std::remove((base + ".sigmf-meta").c_str());
+    state.SetBytesProcessed(int64_t(state.iterations() * block.size()));
+    state.counters["stalls"] = double(stalls);
+    state.SetLabel(direct ? "O_DIRECT" : "buffered");
+}
+BENCHMARK(BM_recorder)->Arg(16384)->UseRealTime();
+
+// ߳ -> ζ -> ̣߳ģڴٶȸ
+// 㿽ǷתΪfc32
+void BM_rx_pipeline(benchmark::State& state)
+{
+    test_config cfg;
+    cfg.cpu_format = "sc16";
+    cfg.bytes_per_samp = bytes_per_sample(cfg.cpu_format);
+    cfg.zero_copy = state.range(0) != 0;
+    cfg.convert = state.range(1) != 0;
+    const size_t spp = 2000;
+    const size_t block_samps = 4 * spp;
+    const size_t block_bytes = block_samps * cfg.bytes_per_samp;
+    const size_t fc32_samps = cfg.convert ? block_samps : 0;
+
+    auto stream = std::make_shared<mock_rx_streamer>(make_signal(cfg.cpu_format, 65536), cfg.bytes_per_samp, spp, RATE);
+    buffer_arena arena(rx_channel::arena_bytes(block_bytes, fc32_samps), false);
+    rx_channel rx(0, 0, stream, arena, block_bytes, fc32_samps);
+    rx.batch = block_samps;
+    rx.rate = RATE;
+    const start_schedule start;
+
+    for (auto _ : state)
+    {
+        const uint64_t target = rx.consumer.consumed_samples.get() + PIPELINE_SAMPS;
+        std::atomic<bool> rx_done{ false };
+        std::atomic<bool> consumer_done{ false };
+        std::thread consumer(consumer_worker, std::ref(rx), std::cref(cfg), std::cref(start), std::cref(consumer_done));
+        std::thread receiver(rx_worker, nullptr, std::ref(rx), std::cref(cfg), std::cref(start), std::cref(rx_done));
+        wait_for(rx.consumer.consumed_samples, target);
+        rx_done = true;
+        receiver.join();
+        consumer_done = true;
+        consumer.join();
+    }
+    state.SetItemsProcessed(int64_t(rx.consumer.consumed_samples.get()));
+    state.SetBytesProcessed(int64_t(rx.consumer.consumed_samples.get() * cfg.bytes_per_samp));
+    state.counters["drops"] = double(rx.metrics.drops.get());
+    state.counters["ns/recv"] = double(rx.metrics.call_ns.get()) / double(std::max<uint64_t>(rx.metrics.calls, 1));
+}
+BENCHMARK(BM_rx_pipeline)->ArgNames({ "zero_copy", "convert" })
+    ->Args({ 0, 0 })->Args({ 1, 0 })->Args({ 0, 1 })->Args({ 1, 1 })->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// ߳ѭԤɵĻʵʱźţΪ1ʱ
+void BM_tx_worker(benchmark::State& state)
+{
+    test_config cfg;
+    cfg.cpu_format = "sc16";
+    cfg.bytes_per_samp = bytes_per_sample(cfg.cpu_format);
+    const size_t spp = 2000;
+    const size_t batch = spp;
+    const size_t buff_bytes = batch * cfg.bytes_per_samp;
+
+    auto stream = std::make_shared<mock_tx_streamer>(cfg.bytes_per_samp, spp);
+    buffer_arena arena((cfg.num_tx_buffers + 1) * buffer_arena::footprint(buff_bytes), false);
+    std::vector<char*> tx_buffs(cfg.num_tx_buffers);
+    signal_generator gen(cfg.signal, RATE, cfg.seed);
+    for (auto& buff : tx_buffs)
+    {
+        buff = static_cast<char*>(arena.allocate(buff_bytes));
+        gen.generate(buff, batch, cfg.cpu_format);
+    }
+    tx_channel tx(0, stream);
+    tx.batch = batch;
+    if (state.range(0) != 0)
+    {
+        tx.gen.reset(new signal_generator(cfg.signal, RATE, cfg.seed));
+        tx.live_buff = static_cast<char*>(arena.allocate(buff_bytes));
+    }
+    const start_schedule start;
+
+    for (auto _ : state)
+    {
+        const uint64_t target = tx.metrics.samples.get() + PIPELINE_SAMPS;
+        std::atomic<bool> tx_done{ false };
+        std::thread sender(tx_worker, std::ref(tx), std::cref(cfg), std::cref(tx_buffs), std::cref(start), std::cref(tx_done));
+        wait_for(tx.metrics.samples, target);
+        tx_done = true;
+        sender.join();
+    }
+    state.SetItemsProcessed(int64_t(tx.metrics.samples.get()));
+    state.SetBytesProcessed(int64_t(tx.metrics.samples.get() * cfg.bytes_per_samp));
+    state.counters["ns/send"] = double(tx.metrics.call_ns.get()) / double(std::max<uint64_t>(tx.metrics.calls, 1));
+}
+BENCHMARK(BM_tx_worker)->ArgName("live_signal")->Arg(0)->Arg(1)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
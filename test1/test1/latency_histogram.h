@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// HDRĶ-ֱͼڼ¼ÿsend()/recv()úʱ()
+// ÿ2پΪSUB_BUCKETSͰ1/SUB_BUCKETS
+// record()ֻһ̵߳ã߳̿ʱȡ
+class latency_histogram
+{
+public:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+    static constexpr size_t NUM_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    latency_histogram() : buckets_(NUM_BUCKETS) {}
+
+    void record(uint64_t value)
+    {
+        // дߣͨĶ--дɣҪǰ׺fetch_addcounterͬ
+        std::atomic<uint64_t>& b = buckets_[bucket_index(value)];
+        b.store(b.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (value > max_.load(std::memory_order_relaxed))
+            max_.store(value, std::memory_order_relaxed);
+    }
+
+    // ۼһֱͼںϲͨ
+    void merge(const latency_histogram& other)
+    {
+        for (size_t i = 0; i < NUM_BUCKETS; i++)
+            buckets_[i].fetch_add(other.buckets_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        if (other.max() > max())
+            max_.store(other.max(), std::memory_order_relaxed);
+    }
+
+    uint64_t count() const
+    {
+        uint64_t n = 0;
+        for (const auto& b : buckets_)
+            n += b.load(std::memory_order_relaxed);
+        return n;
+    }
+
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+    // صpٷλ(0~100)ͰϽ
+    uint64_t percentile(double p) const
+    {
+        const uint64_t total = count();
+        if (total == 0)
+            return 0;
+        uint64_t target = uint64_t(p / 100.0 * double(total) + 0.5);
+        if (target == 0)
+            target = 1;
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < NUM_BUCKETS; i++)
+        {
+            seen += buckets_[i].load(std::memory_order_relaxed);
+            if (seen >= target)
+                return std::min(bucket_upper(i), max());
+        }
+        return max();
+    }
+
+private:
+    static int msb(uint64_t v)
+    {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+        unsigned long idx;
+        _BitScanReverse64(&idx, v);
+        return int(idx);
+#elif defined(__GNUC__)
+        return 63 - __builtin_clzll(v);
+#else
+        int m = 0;
+        while (v >>= 1)
+            m++;
+        return m;
+#endif
+    }
+
+    // 0Ϊ[0, SUB_BUCKETS)Ͱ֮ÿ鸲һ2
+    static size_t bucket_index(uint64_t v)
+    {
+        if (v < SUB_BUCKETS)
+            return size_t(v);
+        const int m = msb(v);
+        const int shift = m - SUB_BUCKET_BITS;
+        const size_t group = size_t(shift + 1);
+        const size_t sub = size_t(v >> shift) - SUB_BUCKETS;
+        return group * SUB_BUCKETS + sub;
+    }
+
+    static uint64_t bucket_upper(size_t idx)
+    {
+        const size_t group = idx >> SUB_BUCKET_BITS;
+        const uint64_t sub = idx & (SUB_BUCKETS - 1);
+        if (group == 0)
+            return sub;
+        const int shift = int(group) - 1;
+        return ((SUB_BUCKETS + sub) << shift) + ((uint64_t(1) << shift) - 1);
+    }
+
+    std::vector<std::atomic<uint64_t>> buckets_;
+    std::atomic<uint64_t> max_{ 0 };
+};
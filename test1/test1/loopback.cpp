@@ -0,0 +1,181 @@
+#include "loopback.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+std::vector<float> make_pn_sequence(int order)
+{
+    // ױԭʽĳͷorderλУȡXAPP052
+    static const unsigned TAPS[][4] = {
+        { 5, 3, 0, 0 }, { 6, 5, 0, 0 }, { 7, 6, 0, 0 }, { 8, 6, 5, 4 },
+        { 9, 5, 0, 0 }, { 10, 7, 0, 0 }, { 11, 9, 0, 0 }, { 12, 6, 4, 1 },
+        { 13, 4, 3, 1 }, { 14, 5, 3, 1 }, { 15, 14, 0, 0 },
+    };
+    if (order < 5 || order > 15)
+        throw std::invalid_argument("PN order must be between 5 and 15");
+
+    const unsigned* taps = TAPS[order - 5];
+    const size_t len = (size_t(1) << order) - 1;
+    std::vector<float> pn(len);
+    uint32_t state = 1;
+    for (size_t i = 0; i < len; i++)
+    {
+        pn[i] = (state & 1) ? 1.0f : -1.0f;
+        uint32_t fb = (state >> (order - 1)) & 1;
+        for (int t = 1; t < 4 && taps[t] != 0; t++)
+            fb ^= (state >> (taps[t] - 1)) & 1;
+        state = ((state << 1) | fb) & ((uint32_t(1) << order) - 1);
+    }
+    return pn;
+}
+
+void frame_clock::mark(uint64_t frame, int64_t host_ns)
+{
+    // ϲλдʱ䣬߾ǰζ֡жʱǷ
+    slot& s = slots_[frame % slots_.size()];
+    s.frame.store(UINT64_MAX, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    s.host_ns.store(host_ns, std::memory_order_relaxed);
+    s.frame.store(frame, std::memory_order_release);
+}
+
+int64_t frame_clock::lookup(uint64_t frame) const
+{
+    const slot& s = slots_[frame % slots_.size()];
+    if (s.frame.load(std::memory_order_acquire) != frame)
+        return -1;
+    const int64_t host_ns = s.host_ns.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (s.frame.load(std::memory_order_relaxed) != frame)
+        return -1;
+    return host_ns;
+}
+
+namespace
+{
+    size_t correlator_size(size_t pn_len)
+    {
+        // FFTȡPNȵ4ϣÿα任3/4ϵЧ
+        size_t n = 1;
+        while (n < pn_len * 4)
+            n <<= 1;
+        return n;
+    }
+}
+
+loopback_analyzer::loopback_analyzer(const std::vector<float>& pn, size_t frame_len, double rate,
+    const frame_clock* frames, double threshold)
+    : pn_len_(pn.size()), frame_len_(frame_len), rate_(rate), frames_(frames), threshold_(threshold),
+    plan_(correlator_size(pn.size())), ref_spectrum_(plan_.size()), buf_(plan_.size()),
+    work_(plan_.size()), energy_(plan_.size() + 1)
+{
+    if (pn_len_ >= frame_len_)
+        throw std::invalid_argument("PN marker must be shorter than the frame");
+
+    for (size_t i = 0; i < pn_len_; i++)
+        ref_spectrum_[i] = std::complex<float>(pn[i], 0.0f);
+    plan_.forward(ref_spectrum_.data());
+    // 1/NһŽοƵף任֮ٹһ
+    const float scale = 1.0f / float(plan_.size());
+    for (auto& r : ref_spectrum_)
+        r = std::conj(r) * scale;
+}
+
+void loopback_analyzer::process(const std::complex<float>* samps, size_t nsamps, int64_t first_index, int64_t host_ns)
+{
+    // ʱ㣩ʱʷӱ¿ʼ
+    if (next_index_ >= 0 && first_index != next_index_)
+    {
+        if (first_index > next_index_)
+            lost_samples += uint64_t(first_index - next_index_);
+        finish_peak();
+        fill_ = 0;
+    }
+    if (fill_ == 0)
+        buf_start_ = first_index;
+    next_index_ = first_index + int64_t(nsamps);
+
+    const size_t n = plan_.size();
+    const size_t keep = pn_len_ - 1;
+    size_t i = 0;
+    while (i < nsamps)
+    {
+        const size_t chunk = std::min(nsamps - i, n - fill_);
+        std::memcpy(buf_.data() + fill_, samps + i, chunk * sizeof(std::complex<float>));
+        fill_ += chunk;
+        i += chunk;
+        if (fill_ < n)
+            break;
+
+        correlate(host_ns);
+        std::memmove(buf_.data(), buf_.data() + n - keep, keep * sizeof(std::complex<float>));
+        buf_start_ += int64_t(n - keep);
+        fill_ = keep;
+    }
+}
+
+void loopback_analyzer::correlate(int64_t host_ns)
+{
+    const size_t n = plan_.size();
+    work_ = buf_;
+    plan_.forward(work_.data());
+    for (size_t k = 0; k < n; k++)
+    {
+        const std::complex<float> a = work_[k], b = ref_spectrum_[k];
+        work_[k] = std::complex<float>(a.real() * b.real() - a.imag() * b.imag(),
+            a.real() * b.imag() + a.imag() * b.real());
+    }
+    plan_.inverse(work_.data());
+
+    energy_[0] = 0;
+    for (size_t k = 0; k < n; k++)
+        energy_[k + 1] = energy_[k] + std::norm(buf_[k]);
+
+    // һϵ|c| / sqrt(L * )뻷޹أȫƥʱΪ1
+    for (size_t j = 0; j + pn_len_ <= n; j++)
+    {
+        const int64_t index = buf_start_ + int64_t(j);
+        if (peak_index_ >= 0 && index - peak_index_ > int64_t(pn_len_))
+            finish_peak();
+        if (index < 0)
+            continue;
+
+        const double window = energy_[j + pn_len_] - energy_[j];
+        if (window <= 0)
+            continue;
+        const double ncc = std::abs(work_[j]) / std::sqrt(double(pn_len_) * window);
+        if (ncc >= threshold_ && (peak_index_ < 0 || ncc > peak_value_))
+        {
+            peak_index_ = index;
+            peak_value_ = ncc;
+            peak_host_ns_ = host_ns;
+        }
+    }
+}
+
+void loopback_analyzer::finish_peak()
+{
+    if (peak_index_ < 0)
+        return;
+    const int64_t index = peak_index_;
+    peak_index_ = -1;
+
+    const int64_t frame = index / int64_t(frame_len_);
+    const int64_t delay = index - frame * int64_t(frame_len_);
+    ++markers;
+    if (last_frame_ >= 0 && frame > last_frame_ + 1)
+        missed += uint64_t(frame - last_frame_ - 1);
+    if (last_delay_ >= 0 && delay != last_delay_)
+        ++slips;
+    last_frame_ = frame;
+    last_delay_ = delay;
+
+    path_latency.record(uint64_t(double(delay) / rate_ * 1e9));
+    if (frames_ != nullptr)
+    {
+        const int64_t sent_ns = frames_->lookup(uint64_t(frame));
+        if (sent_ns >= 0 && peak_host_ns_ >= sent_ns)
+            host_latency.record(uint64_t(peak_host_ns_ - sent_ns));
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "fft.h"
+#include "latency_histogram.h"
+#include "metrics.h"
+#include <atomic>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ԷλĴɵ󳤶Уȡֵ1Ϊ2^order-1orderȡ5~15
+std::vector<float> make_pn_sequence(int order);
+
+// ̼߳¼ÿ֡֡ΪPNǣsend()ʱ䣬̰߳֡Ųѯ
+class frame_clock
+{
+public:
+    explicit frame_clock(size_t slots = 1024) : slots_(slots) {}
+
+    // ֻɷ̵߳
+    void mark(uint64_t frame, int64_t host_ns);
+
+    // ֡δͻ¼ѱʱ-1
+    int64_t lookup(uint64_t frame) const;
+
+private:
+    struct slot
+    {
+        std::atomic<uint64_t> frame{ UINT64_MAX };
+        std::atomic<int64_t> host_ns{ 0 };
+    };
+    std::vector<slot> slots_;
+};
+
+// طFFT(overlap-save)ڽѰPN
+// 㰴ʱӦӶʱʼʱȫ±꣬Ͷ˵k֡ı±k*frame_len
+// ˱λö֡ȡǷ͵յӳ٣ҪӳСһ֡
+// process()ֻһ̵߳ãֱͼɱ߳ʱȡ
+class loopback_analyzer
+{
+public:
+    // thresholdΪһϵޣȫƥΪ1ԼΪ1/sqrt(PN)
+    loopback_analyzer(const std::vector<float>& pn, size_t frame_len, double rate,
+        const frame_clock* frames, double threshold = 0.25);
+
+    // first_indexһȫ±ꣻhost_nsrecv()ʱʱ
+    void process(const std::complex<float>* samps, size_t nsamps, int64_t first_index, int64_t host_ns);
+
+    double rate() const { return rate_; }
+
+    counter markers;                // ҵı
+    counter missed;                 // ֮ȱٵ֡
+    counter slips;                  // ӳٷ仯Ĵʧ㣩
+    counter lost_samples;           // ʱȱ
+    latency_histogram path_latency; // 豸DACADCӳ(ns)
+    latency_histogram host_latency; // ̵߳send()߳recv()(ns)
+
+private:
+    void correlate(int64_t host_ns);
+    void finish_peak();
+
+    const size_t pn_len_;
+    const size_t frame_len_;
+    const double rate_;
+    const frame_clock* frames_;
+    const double threshold_;
+
+    fft_plan plan_;
+    std::vector<std::complex<float>> ref_spectrum_; // PNƵ׵Ĺ
+    std::vector<std::complex<float>> buf_;          // ǰpn_len-1һεĽβ
+    std::vector<std::complex<float>> work_;
+    std::vector<double> energy_;                    // buf_ǰ׺
+    size_t fill_ = 0;
+    int64_t buf_start_ = 0;   // buf_[0]ȫ±
+    int64_t next_index_ = -1; // һӦеȫ±
+
+    // ޵ط壺pn_lenΧȡֵ
+    int64_t peak_index_ = -1;
+    double peak_value_ = 0;
+    int64_t peak_host_ns_ = 0;
+
+    int64_t last_frame_ = -1;
+    int64_t last_delay_ = -1;
+};
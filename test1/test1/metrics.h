@@ -0,0 +1,106 @@
+#pragma once
+
+#include "cache_line.h"
+#include "latency_histogram.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// д߼ֻ߳д룬߳̿ʱȡ
+// ֻһдߣrelaxedload+storelockǰ׺fetch_add
+class counter
+{
+public:
+    counter& operator+=(uint64_t n)
+    {
+        v_.store(v_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        return *this;
+    }
+
+    counter& operator++() { return *this += 1; }
+
+    // ֵֻڸˮλͳ
+    void update_max(uint64_t v)
+    {
+        if (v > v_.load(std::memory_order_relaxed))
+            v_.store(v, std::memory_order_relaxed);
+    }
+
+    // ˲ʱֱֵӸ
+    void set(uint64_t v) { v_.store(v, std::memory_order_relaxed); }
+
+    uint64_t get() const { return v_.load(std::memory_order_relaxed); }
+    operator uint64_t() const { return get(); }
+
+private:
+    std::atomic<uint64_t> v_{ 0 };
+};
+
+// ÿṹ嶼ֻһ߳д룬ռУ
+// ̵ͬ߳ļͬһϣα
+
+// ߳
+struct alignas(CACHE_LINE_SIZE) tx_metrics
+{
+    counter samples;
+    counter errors;                 // send()δ(ʱ)
+    counter calls;
+    counter call_ns;                // send()ʱ֮
+    counter cpu_ns;                 // ߳ĵCPUʱ䣬߳̽ʱд
+    latency_histogram send_latency; // ÿsend()ʱ(ns)
+    counter flow_depth;             // Ӧصǰķǰ()
+    counter flow_batch;             // Ӧصǰÿsend()
+    counter flow_adjustments;       // ǰ
+    latency_histogram send_ahead;   // Ӧʱÿsend()ǰƵǰ(ns)ӳ
+};
+
+// 첽Ϣ߳
+struct alignas(CACHE_LINE_SIZE) tx_async_metrics
+{
+    counter underflows;
+    counter seq_errors;
+    counter time_errors;
+    counter burst_acks;
+};
+
+// м̣߳ͬʱдԷͨtx_metricsͽͨconsumer_metrics
+struct alignas(CACHE_LINE_SIZE) relay_metrics
+{
+    counter blocks;
+    counter late;                   // send()ʱѹʱĿ
+    counter skipped;                // 0ûз͵Ŀ
+    counter process_ns;             // صʱ֮
+    latency_histogram budget_used;  // 㵽send()ؾ豸ʱ(ns)offsetٵ
+};
+
+// ߳
+struct alignas(CACHE_LINE_SIZE) rx_metrics
+{
+    // մ֮
+    uint64_t errors() const
+    {
+        return overflows + seq_errors + timeouts + late_commands + other_errors;
+    }
+
+    counter samples;
+    counter overflows;              // 'O'
+    counter seq_errors;             // 'D'㶪
+    counter timeouts;
+    counter late_commands;
+    counter other_errors;
+    counter restarts;               // Ĵ
+    counter drops;                  // ζĿ
+    counter drained_samples;        // ͣſյ㣬Ѽsamples
+    counter calls;
+    counter call_ns;                // recv()ʱ֮ͣȴݵʱ
+    counter cpu_ns;                 // ߳ĵCPUʱ䣬߳̽ʱд
+    latency_histogram recv_latency; // ÿrecv()ʱ(ns)
+};
+
+// ߳
+struct alignas(CACHE_LINE_SIZE) consumer_metrics
+{
+    counter consumed_samples;
+    counter converted_samples;
+    counter ring_high_water;        // ζռõλ
+};
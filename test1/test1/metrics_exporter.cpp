@@ -0,0 +1,352 @@
+#include "metrics_exporter.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#if defined(_MSC_VER)
+#pragma comment(lib, "ws2_32.lib")
+#endif
+#else
+#include <netdb.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#if defined(_WIN32)
+    typedef SOCKET socket_t;
+    const socket_t BAD_SOCKET = INVALID_SOCKET;
+    void close_socket(socket_t s) { closesocket(s); }
+    const int SEND_FLAGS = 0;
+#else
+    typedef int socket_t;
+    const socket_t BAD_SOCKET = -1;
+    void close_socket(socket_t s) { close(s); }
+    // ԶȹرʱSIGPIPE
+    const int SEND_FLAGS = MSG_NOSIGNAL;
+#endif
+
+    const size_t STATSD_PACKET = 1400;  // ÿUDPֽMTU
+
+    struct addr_list
+    {
+        addrinfo* head = nullptr;
+        ~addr_list() { if (head != nullptr) freeaddrinfo(head); }
+    };
+
+    // ׽ֲγԽĵַlistenΪtrueʱ󶨲ӣUDPֻĬĿĵַ
+    socket_t open_socket(const std::string& host, const std::string& port, int type, bool listen_mode)
+    {
+        addrinfo hints;
+        std::memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = type;
+        hints.ai_flags = listen_mode ? AI_PASSIVE : 0;
+        addr_list addrs;
+        if (getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &addrs.head) != 0)
+            return BAD_SOCKET;
+        for (addrinfo* a = addrs.head; a != nullptr; a = a->ai_next)
+        {
+            const socket_t s = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+            if (s == BAD_SOCKET)
+                continue;
+            if (listen_mode)
+            {
+                // ֮¼ͬһ˿
+                const int on = 1;
+                setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&on), sizeof(on));
+                if (bind(s, a->ai_addr, int(a->ai_addrlen)) == 0 && listen(s, 8) == 0)
+                    return s;
+            }
+            else if (connect(s, a->ai_addr, int(a->ai_addrlen)) == 0)
+                return s;
+            close_socket(s);
+        }
+        return BAD_SOCKET;
+    }
+
+    bool send_all(socket_t s, const std::string& data)
+    {
+        size_t sent = 0;
+        while (sent < data.size())
+        {
+            const auto n = send(s, data.data() + sent, int(data.size() - sent), SEND_FLAGS);
+            if (n <= 0)
+                return false;
+            sent += size_t(n);
+        }
+        return true;
+    }
+
+    // ԭౣ10λЧ
+    std::string format_value(double v)
+    {
+        if (v == std::floor(v) && std::abs(v) < 1e15)
+            return std::to_string(int64_t(v));
+        std::ostringstream ss;
+        ss << std::setprecision(10) << v;
+        return ss.str();
+    }
+
+    // StatsDûбǩǩֵνֺ棻ֻĸֺ»
+    std::string statsd_name(const std::string& prefix, const std::string& name, const std::string& labels)
+    {
+        std::string out = prefix + "." + name;
+        bool in_value = false;
+        for (char c : labels)
+        {
+            if (c == '"')
+            {
+                in_value = !in_value;
+                if (in_value)
+                    out += '.';
+                continue;
+            }
+            if (in_value)
+                out += (std::isalnum(static_cast<unsigned char>(c)) != 0) ? c : '_';
+        }
+        return out;
+    }
+
+    std::string join_labels(const std::string& a, const std::string& b)
+    {
+        return (a.empty() || b.empty()) ? a + b : a + "," + b;
+    }
+}
+
+metric_set::family& metric_set::find(const std::string& name, const std::string& help, const char* type)
+{
+    const auto it = index_.find(name);
+    if (it != index_.end())
+        return families_[it->second];
+    index_[name] = families_.size();
+    families_.push_back({ name, help, type, {} });
+    return families_.back();
+}
+
+void metric_set::counter(const std::string& name, const std::string& help, const std::string& labels, double value)
+{
+    find(name, help, "counter").samples.push_back({ "", labels, value });
+}
+
+void metric_set::gauge(const std::string& name, const std::string& help, const std::string& labels, double value)
+{
+    find(name, help, "gauge").samples.push_back({ "", labels, value });
+}
+
+void metric_set::summary(const std::string& name, const std::string& help, const std::string& labels,
+    const latency_histogram& hist, int64_t sum_ns)
+{
+    family& f = find(name, help, "summary");
+    f.samples.push_back({ "", join_labels(labels, "quantile=\"0.5\""), hist.percentile(50.0) / 1e9 });
+    f.samples.push_back({ "", join_labels(labels, "quantile=\"0.99\""), hist.percentile(99.0) / 1e9 });
+    f.samples.push_back({ "", join_labels(labels, "quantile=\"0.999\""), hist.percentile(99.9) / 1e9 });
+    if (sum_ns >= 0)
+        f.samples.push_back({ "_sum", labels, double(sum_ns) / 1e9 });
+    f.samples.push_back({ "_count", labels, double(hist.count()) });
+    gauge(name + "_max", help + " (maximum)", labels, double(hist.max()) / 1e9);
+}
+
+metrics_exporter::metrics_exporter(const exporter_params& params)
+    : params_(params)
+{
+#if defined(_WIN32)
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0)
+        throw std::runtime_error("WSAStartup failed");
+#endif
+    if (!params_.statsd.empty())
+    {
+        const size_t colon = params_.statsd.rfind(':');
+        const socket_t s = (colon == std::string::npos || colon == 0) ? BAD_SOCKET
+            : open_socket(params_.statsd.substr(0, colon), params_.statsd.substr(colon + 1), SOCK_DGRAM, false);
+        if (s == BAD_SOCKET)
+            throw std::runtime_error("Cannot resolve StatsD address " + params_.statsd + " (expected host:port)");
+        statsd_fd_ = intptr_t(s);
+    }
+    if (params_.http_port > 0)
+    {
+        const socket_t s = open_socket(params_.http_bind, std::to_string(params_.http_port), SOCK_STREAM, true);
+        if (s == BAD_SOCKET)
+        {
+            if (statsd_fd_ >= 0)
+                close_socket(socket_t(statsd_fd_));
+            throw std::runtime_error("Cannot listen on " + params_.http_bind + ":" + std::to_string(params_.http_port));
+        }
+        listen_fd_ = intptr_t(s);
+    }
+}
+
+metrics_exporter::~metrics_exporter()
+{
+    stop();
+    if (listen_fd_ >= 0)
+        close_socket(socket_t(listen_fd_));
+    if (statsd_fd_ >= 0)
+        close_socket(socket_t(statsd_fd_));
+#if defined(_WIN32)
+    WSACleanup();
+#endif
+}
+
+void metrics_exporter::start(collect_fn collect, const thread_placement& placement)
+{
+    collect_ = std::move(collect);
+    thread_ = start_thread(placement, &metrics_exporter::run, this);
+}
+
+void metrics_exporter::stop()
+{
+    if (!thread_.joinable())
+        return;
+    stop_ = true;
+    thread_.join();
+    if (statsd_fd_ >= 0)
+        push_statsd();
+}
+
+void metrics_exporter::run()
+{
+    typedef std::chrono::steady_clock clock;
+    const auto interval = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(params_.statsd_interval));
+    auto next_push = clock::now() + interval;
+    while (!stop_)
+    {
+        // ȴ100ms֤stop()ʱ
+        auto wait = std::chrono::milliseconds(100);
+        if (statsd_fd_ >= 0)
+            wait = std::min(wait, std::chrono::duration_cast<std::chrono::milliseconds>(next_push - clock::now()));
+        wait = std::max(wait, std::chrono::milliseconds(0));
+
+        if (listen_fd_ >= 0)
+        {
+            fd_set readable;
+            FD_ZERO(&readable);
+            FD_SET(socket_t(listen_fd_), &readable);
+            timeval tv;
+            tv.tv_sec = 0;
+            tv.tv_usec = long(wait.count() * 1000);
+            if (select(int(listen_fd_ + 1), &readable, nullptr, nullptr, &tv) > 0)
+                serve_http();
+        }
+        else
+            std::this_thread::sleep_for(wait);
+
+        if (statsd_fd_ >= 0 && clock::now() >= next_push)
+        {
+            push_statsd();
+            next_push = std::max(next_push + interval, clock::now());
+        }
+    }
+}
+
+void metrics_exporter::serve_http()
+{
+    const socket_t s = accept(socket_t(listen_fd_), nullptr, nullptr);
+    if (s == BAD_SOCKET)
+        return;
+
+    // ֮ײģΪֹͻռõ߳1
+#if defined(_WIN32)
+    const DWORD timeout_ms = 1000;
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout_ms), sizeof(timeout_ms));
+#else
+    timeval tv{ 1, 0 };
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+#endif
+    std::string request;
+    char buff[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192)
+    {
+        const auto n = recv(s, buff, int(sizeof(buff)), 0);
+        if (n <= 0)
+            break;
+        request.append(buff, size_t(n));
+    }
+
+    std::istringstream line(request.substr(0, request.find("\r\n")));
+    std::string method, path;
+    line >> method >> path;
+    std::string status = "200 OK", body;
+    if (method != "GET")
+        status = "405 Method Not Allowed";
+    else if (path != "/metrics" && path != "/")
+        status = "404 Not Found";
+    else
+    {
+        metric_set metrics;
+        collect_(metrics);
+        body = prometheus_text(metrics, params_.prefix);
+    }
+    send_all(s, "HTTP/1.0 " + status + "\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+        + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body);
+    close_socket(s);
+}
+
+void metrics_exporter::push_statsd()
+{
+    metric_set metrics;
+    collect_(metrics);
+
+    std::string packet;
+    auto flush = [&]()
+    {
+        if (!packet.empty())
+            send(socket_t(statsd_fd_), packet.data(), int(packet.size()), 0);
+        packet.clear();
+    };
+    for (const metric_set::family& f : metrics.families())
+    {
+        for (const metric_set::sample& s : f.samples)
+        {
+            const std::string name = statsd_name(params_.prefix, f.name + s.suffix, s.labels);
+            const bool is_counter = f.type == "counter" || s.suffix == "_sum" || s.suffix == "_count";
+            std::string line;
+            if (is_counter)
+            {
+                // С˵һ飬0¼
+                double& prev = statsd_prev_[name];
+                const double delta = (s.value >= prev) ? s.value - prev : s.value;
+                prev = s.value;
+                line = name + ":" + format_value(delta) + "|c";
+            }
+            else
+                line = name + ":" + format_value(s.value) + "|g";
+            if (packet.size() + line.size() + 1 > STATSD_PACKET)
+                flush();
+            packet += (packet.empty() ? "" : "\n") + line;
+        }
+    }
+    flush();
+}
+
+std::string metrics_exporter::prometheus_text(const metric_set& metrics, const std::string& prefix)
+{
+    std::ostringstream out;
+    for (const metric_set::family& f : metrics.families())
+    {
+        const std::string name = prefix + "_" + f.name;
+        out << "# HELP " << name << " " << f.help << "\n# TYPE " << name << " " << f.type << "\n";
+        for (const metric_set::sample& s : f.samples)
+        {
+            out << name << s.suffix;
+            if (!s.labels.empty())
+                out << "{" << s.labels << "}";
+            out << " " << format_value(s.value) << "\n";
+        }
+    }
+    return out.str();
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "latency_histogram.h"
+#include "thread_placement.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ָ굼
+struct exporter_params
+{
+    int http_port = 0;              // PrometheusıʽHTTP˿ڣ0ʾ
+    std::string http_bind = "0.0.0.0"; // HTTPַ
+    std::string statsd;             // StatsDַhost:portձʾ
+    double statsd_interval = 10;    // ͼ()
+    std::string prefix = "usrp";    // ָǰ׺
+
+    bool enabled() const { return http_port > 0 || !statsd.empty(); }
+};
+
+// һβɼȫָꣻָͬĶɱǩ֣chan="0"
+class metric_set
+{
+public:
+    // ļ
+    void counter(const std::string& name, const std::string& help, const std::string& labels, double value);
+    // ɼ˲ʱֵ
+    void gauge(const std::string& name, const std::string& help, const std::string& labels, double value);
+    // ʱֲp50/p99/p99.9λֵ()sum_nsΪ֮ͣʾûͳƣ_sum
+    void summary(const std::string& name, const std::string& help, const std::string& labels,
+        const latency_histogram& hist, int64_t sum_ns);
+
+    struct sample
+    {
+        std::string suffix;         // ֺ׺"_sum"
+        std::string labels;
+        double value;
+    };
+    struct family
+    {
+        std::string name;
+        std::string help;
+        std::string type;           // countergaugesummary
+        std::vector<sample> samples;
+    };
+    const std::vector<family>& families() const { return families_; }
+
+private:
+    family& find(const std::string& name, const std::string& help, const char* type);
+
+    std::vector<family> families_;
+    std::map<std::string, size_t> index_;
+};
+
+// ָ굼̣߳裨HTTPStatsD͵ڣòɼ
+// ɼֻȡ̵߳ĵд߼ֱͼշʹ̲߳Ϊκζ⹤
+// HTTPÿֻһӣGET /metricsPrometheusıʽ
+// StatsDÿһΣϴεĲֵ(|c)͵ǰֵ(|g)
+class metrics_exporter
+{
+public:
+    typedef std::function<void(metric_set&)> collect_fn;
+
+    // HTTP˿ںStatsD׽֣˿޷StatsDַ޷ʱ׳쳣
+    explicit metrics_exporter(const exporter_params& params);
+    ~metrics_exporter();
+
+    metrics_exporter(const metrics_exporter&) = delete;
+    metrics_exporter& operator=(const metrics_exporter&) = delete;
+
+    // ̣߳˺collectڵ߳е
+    void start(collect_fn collect, const thread_placement& placement);
+
+    // һStatsḌֹ֮ͣ߳ٵòɼ
+    void stop();
+
+    // Prometheusıʽ(0.0.4)
+    static std::string prometheus_text(const metric_set& metrics, const std::string& prefix);
+
+private:
+    void run();
+    void serve_http();
+    void push_statsd();
+
+    const exporter_params params_;
+    collect_fn collect_;
+    intptr_t listen_fd_ = -1;
+    intptr_t statsd_fd_ = -1;
+    std::map<std::string, double> statsd_prev_; // ϴ͵ļֵ
+    std::atomic<bool> stop_{ false };
+    std::thread thread_;
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <uhd/stream.hpp>
+#include <uhd/types/metadata.hpp>
+#include <uhd/types/stream_cmd.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// 豸ĽڴٶѭһԤɵ㣬ʱ
+// ̡߲߳ζк̱߳Ŀ
+class mock_rx_streamer : public uhd::rx_streamer
+{
+public:
+    mock_rx_streamer(std::vector<char> pattern, size_t bytes_per_samp, size_t spp, double rate)
+        : pattern_(std::move(pattern)), bytes_per_samp_(bytes_per_samp), spp_(spp), rate_(rate)
+    {
+    }
+
+    size_t get_num_channels() const override { return 1; }
+    size_t get_max_num_samps() const override { return spp_; }
+
+    size_t recv(const buffs_type& buffs, const size_t nsamps, uhd::rx_metadata_t& md,
+        const double timeout, const bool one_packet) override
+    {
+        md = uhd::rx_metadata_t();
+        if (!streaming_)
+        {
+            // ʵ豸һδʱȵʱ
+            std::this_thread::sleep_for(std::chrono::duration<double>(std::min(timeout, 0.001)));
+            md.error_code = uhd::rx_metadata_t::ERROR_CODE_TIMEOUT;
+            return 0;
+        }
+        const size_t n = one_packet ? std::min(nsamps, spp_) : nsamps;
+        char* out = static_cast<char*>(buffs[0]);
+        size_t bytes = n * bytes_per_samp_;
+        while (bytes > 0)
+        {
+            const size_t k = std::min(bytes, pattern_.size() - pos_);
+            std::memcpy(out, pattern_.data() + pos_, k);
+            out += k;
+            bytes -= k;
+            pos_ = (pos_ + k) % pattern_.size();
+        }
+        md.has_time_spec = true;
+        md.time_spec = base_ + uhd::time_spec_t(double(produced_) / rate_);
+        produced_ += n;
+        return n;
+    }
+
+    void issue_stream_cmd(const uhd::stream_cmd_t& cmd) override
+    {
+        streaming_ = cmd.stream_mode != uhd::stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS;
+        base_ = cmd.stream_now ? uhd::time_spec_t(0.0) : cmd.time_spec;
+        produced_ = 0;
+    }
+
+private:
+    const std::vector<char> pattern_;
+    const size_t bytes_per_samp_;
+    const size_t spp_;
+    const double rate_;
+    size_t pos_ = 0;
+    bool streaming_ = false;
+    uint64_t produced_ = 0;
+    uhd::time_spec_t base_;
+};
+
+// 豸ķ㿽һ̶ĻУģ⴫ȡݣ
+class mock_tx_streamer : public uhd::tx_streamer
+{
+public:
+    mock_tx_streamer(size_t bytes_per_samp, size_t spp)
+        : bytes_per_samp_(bytes_per_samp), spp_(spp), sink_(spp * bytes_per_samp)
+    {
+    }
+
+    size_t get_num_channels() const override { return 1; }
+    size_t get_max_num_samps() const override { return spp_; }
+
+    size_t send(const buffs_type& buffs, const size_t nsamps, const uhd::tx_metadata_t& md,
+        const double timeout) override
+    {
+        (void)md;
+        (void)timeout;
+        // ʵһ
+        const char* in = static_cast<const char*>(buffs[0]);
+        size_t bytes = nsamps * bytes_per_samp_;
+        while (bytes > 0)
+        {
+            const size_t k = std::min(bytes, sink_.size());
+            std::memcpy(sink_.data(), in, k);
+            in += k;
+            bytes -= k;
+        }
+        return nsamps;
+    }
+
+    bool recv_async_msg(uhd::async_metadata_t& md, double timeout) override
+    {
+        (void)md;
+        std::this_thread::sleep_for(std::chrono::duration<double>(std::min(timeout, 0.001)));
+        return false;
+    }
+
+private:
+    const size_t bytes_per_samp_;
+    const size_t spp_;
+    std::vector<char> sink_;
+};
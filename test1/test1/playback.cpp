@@ -0,0 +1,192 @@
+#include "playback.h"
+#include "convert.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const size_t PAGE_BYTES = 4096;
+
+    bool ends_with(const std::string& s, const std::string& suffix)
+    {
+        return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    // ȡԪ"key": ֵ֮ȥţҲʱؿգֻ¼дƽֶ
+    std::string json_value(const std::string& json, const std::string& key)
+    {
+        const std::string quoted = "\"" + key + "\"";
+        size_t pos = json.find(quoted);
+        if (pos == std::string::npos)
+            return "";
+        pos = json.find(':', pos + quoted.size());
+        if (pos == std::string::npos)
+            return "";
+        pos = json.find_first_not_of(" \t\r\n", pos + 1);
+        if (pos == std::string::npos)
+            return "";
+        if (json[pos] == '"')
+        {
+            const size_t end = json.find('"', pos + 1);
+            return (end == std::string::npos) ? "" : json.substr(pos + 1, end - pos - 1);
+        }
+        const size_t end = json.find_first_of(",}\r\n", pos);
+        return json.substr(pos, end - pos);
+    }
+
+    std::string cpu_format_of(const std::string& datatype)
+    {
+        if (datatype == "ci16_le")
+            return "sc16";
+        if (datatype == "ci8" || datatype == "ci8_le")
+            return "sc8";
+        if (datatype == "cf32_le")
+            return "fc32";
+        return "";
+    }
+}
+
+playback_file::playback_file(const std::string& path, const std::string& cpu_format, bool loop)
+    : data_path_(path), bytes_per_samp_(bytes_per_sample(cpu_format)), loop_(loop)
+{
+    // SigMFͣ
+    std::string meta_path;
+    if (ends_with(path, ".sigmf-meta"))
+    {
+        meta_path = path;
+        data_path_ = path.substr(0, path.size() - 4) + "data";
+    }
+    else if (ends_with(path, ".sigmf-data"))
+        meta_path = path.substr(0, path.size() - 4) + "meta";
+    if (!meta_path.empty())
+    {
+        std::ifstream meta(meta_path);
+        if (!meta)
+            throw std::runtime_error("Cannot open " + meta_path);
+        const std::string json((std::istreambuf_iterator<char>(meta)), std::istreambuf_iterator<char>());
+        const std::string datatype = json_value(json, "core:datatype");
+        const std::string format = cpu_format_of(datatype);
+        if (format.empty())
+            throw std::runtime_error("Unsupported SigMF datatype \"" + datatype + "\" in " + meta_path);
+        if (format != cpu_format)
+            throw std::runtime_error(meta_path + " holds " + datatype + " samples; use --format " + format);
+        const std::string rate = json_value(json, "core:sample_rate");
+        if (!rate.empty())
+            sample_rate_ = std::stod(rate);
+    }
+
+#if defined(_WIN32)
+    HANDLE h = CreateFileA(data_path_.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (h == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("Cannot open " + data_path_);
+    file_ = h;
+    LARGE_INTEGER size;
+    GetFileSizeEx(h, &size);
+    file_bytes_ = uint64_t(size.QuadPart);
+    if (file_bytes_ >= bytes_per_samp_)
+    {
+        mapping_ = CreateFileMappingA(h, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_ != nullptr)
+            base_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    }
+#else
+    const int fd = open(data_path_.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Cannot open " + data_path_ + ": " + std::strerror(errno));
+    struct stat st;
+    fstat(fd, &st);
+    file_bytes_ = uint64_t(st.st_size);
+    if (file_bytes_ >= bytes_per_samp_)
+    {
+        void* p = mmap(nullptr, file_bytes_, PROT_READ, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED)
+        {
+            base_ = static_cast<const char*>(p);
+            // ˳ʣں˼ӴԤڣҳԾ
+            madvise(p, file_bytes_, MADV_SEQUENTIAL);
+        }
+    }
+    // ӳ佨ļͲҪ
+    close(fd);
+#endif
+
+    num_samps_ = file_bytes_ / bytes_per_samp_;
+    if (num_samps_ == 0)
+        throw std::runtime_error(data_path_ + " has no " + cpu_format + " samples");
+    if (base_ == nullptr)
+        throw std::runtime_error("Cannot map " + data_path_);
+}
+
+playback_file::~playback_file()
+{
+    stop_ = true;
+    for (auto& t : prefetchers_)
+        t.join();
+
+#if defined(_WIN32)
+    if (base_ != nullptr)
+        UnmapViewOfFile(base_);
+    if (mapping_ != nullptr)
+        CloseHandle(mapping_);
+    CloseHandle(static_cast<HANDLE>(file_));
+#else
+    if (base_ != nullptr)
+        munmap(const_cast<char*>(base_), file_bytes_);
+#endif
+}
+
+void playback_file::start_prefetch(const counter& progress, size_t threads, size_t window_bytes,
+    const thread_placement& placement)
+{
+    progress_ = &progress;
+    for (size_t i = 0; i < threads; i++)
+        prefetchers_.push_back(start_thread(placement.for_thread(i), &playback_file::prefetch_loop,
+            this, i, threads, window_bytes));
+}
+
+void playback_file::prefetch_loop(size_t index, size_t threads, size_t window_bytes)
+{
+    // λð͵ֽƣѭʱļȡ
+    uint64_t done = 0;
+    volatile char sink = 0;
+    while (!stop_)
+    {
+        const uint64_t sent = progress_->get() * bytes_per_samp_;
+        uint64_t end = sent + window_bytes;
+        if (!loop_)
+            end = std::min<uint64_t>(end, file_bytes_);
+        uint64_t page = std::max(done, sent) / PAGE_BYTES;
+
+#if !defined(_WIN32)
+        // һ߳ȶڷ첽Ԥҳɸ̰߳ҳȷڷǰȱҳ
+        if (index == 0 && end > sent)
+        {
+            const uint64_t from = sent % file_bytes_ / PAGE_BYTES * PAGE_BYTES;
+            madvise(const_cast<char*>(base_) + from,
+                size_t(std::min<uint64_t>(end - sent, file_bytes_ - from)), MADV_WILLNEED);
+        }
+#endif
+        for (; page * PAGE_BYTES < end; page++)
+        {
+            if (page % threads != index)
+                continue;
+            sink = sink + base_[page * PAGE_BYTES % file_bytes_];
+        }
+        done = std::max(done, end);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "metrics.h"
+#include "thread_placement.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// طļ¼ƵIQļֻӳ䵽ڴ棬ֱ߳Ӵӳsend()
+// ļ.sigmf-data.sigmf-metaβʱSigMFȡԪݣͱcpu_formatһ£
+// cpu_formatԭʼ֯IQ
+class playback_file
+{
+public:
+    playback_file(const std::string& path, const std::string& cpu_format, bool loop);
+    ~playback_file();
+
+    playback_file(const playback_file&) = delete;
+    playback_file& operator=(const playback_file&) = delete;
+
+    // Ԥ̣߳ͽȰ֮window_bytesҳǰ룬̰߳ҳֵ
+    // progressΪ̵߳ѷ
+    void start_prefetch(const counter& progress, size_t threads, size_t window_bytes,
+        const thread_placement& placement);
+
+    // λposʼȡmax_samps㣬ʵʸļĩβʱʣ
+    size_t read(uint64_t pos, size_t max_samps, const char*& data) const
+    {
+        const uint64_t n = std::min<uint64_t>(max_samps, num_samps_ - pos);
+        data = base_ + pos * bytes_per_samp_;
+        return size_t(n);
+    }
+
+    uint64_t num_samps() const { return num_samps_; }
+    bool loop() const { return loop_; }
+    const std::string& data_path() const { return data_path_; }
+    double sample_rate() const { return sample_rate_; } // SigMFԪݣԭʼļΪ0
+
+private:
+    void prefetch_loop(size_t index, size_t threads, size_t window_bytes);
+
+    std::string data_path_;
+    size_t bytes_per_samp_;
+    bool loop_;
+    double sample_rate_ = 0;
+    uint64_t num_samps_ = 0;
+    uint64_t file_bytes_ = 0;
+    const char* base_ = nullptr;
+#if defined(_WIN32)
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+
+    const counter* progress_ = nullptr;
+    std::atomic<bool> stop_{ false };
+    std::vector<std::thread> prefetchers_;
+};
@@ -0,0 +1,145 @@
+#include "psd_monitor.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+    float to_db(double p)
+    {
+        return (p > 0) ? float(10.0 * std::log10(p)) : -200.0f;
+    }
+}
+
+psd_monitor::psd_monitor(const psd_params& params, double rate)
+    : params_(params), rate_(rate), plan_(params.fft_size)
+{
+    if (params_.alpha <= 0 || params_.alpha > 1)
+        throw std::invalid_argument("PSD averaging factor must be in (0, 1]");
+    const size_t n = params_.fft_size;
+    const double pi = std::acos(-1.0);
+    window_.resize(n);
+    double sum = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        window_[i] = float(0.5 - 0.5 * std::cos(2 * pi * double(i) / double(n)));
+        sum += window_[i];
+    }
+    norm_ = float(sum * sum);
+    frame_.resize(n);
+    avg_.assign(n, 0.0f);
+    work_.resize(n);
+
+    // ֡޻֡һ֡ʱ֡
+    const double stride = (params_.frames_per_sec > 0) ? rate / params_.frames_per_sec : 0;
+    stride_ = std::max<size_t>(n, size_t(stride));
+    publish_samples_ = std::max<uint64_t>(1, uint64_t(params_.publish_interval * rate));
+}
+
+void psd_monitor::process(const std::complex<float>* samps, size_t nsamps, int64_t first_index)
+{
+    if (next_index_ >= 0 && first_index != next_index_)
+    {
+        ++gaps;
+        fill_ = 0;
+        skip_ = 0;
+    }
+    next_index_ = first_index + int64_t(nsamps);
+
+    size_t pos = 0;
+    while (pos < nsamps)
+    {
+        // ߽紦ضϣĹøһ
+        const size_t n = size_t(std::min<uint64_t>(nsamps - pos, publish_samples_ - interval_samples_));
+        const std::complex<float>* s = samps + pos;
+
+        float energy = 0, peak = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            const float p = s[i].real() * s[i].real() + s[i].imag() * s[i].imag();
+            energy += p;
+            peak = std::max(peak, p);
+        }
+        interval_energy_ += energy;
+        interval_max_ = std::max(interval_max_, peak);
+        interval_samples_ += n;
+        samples_ += n;
+
+        // ֡㣬ٰ뵱ǰ֡
+        size_t i = 0;
+        while (i < n)
+        {
+            if (skip_ > 0)
+            {
+                const size_t k = std::min(skip_, n - i);
+                skip_ -= k;
+                i += k;
+                continue;
+            }
+            const size_t k = std::min(frame_.size() - fill_, n - i);
+            std::copy(s + i, s + i + k, frame_.begin() + fill_);
+            fill_ += k;
+            i += k;
+            if (fill_ == frame_.size())
+            {
+                analyze_frame();
+                fill_ = 0;
+                skip_ = stride_ - frame_.size();
+            }
+        }
+
+        pos += n;
+        if (interval_samples_ == publish_samples_)
+            publish(first_index + int64_t(pos) - 1);
+    }
+}
+
+void psd_monitor::analyze_frame()
+{
+    const size_t n = frame_.size();
+    for (size_t i = 0; i < n; i++)
+        frame_[i] *= window_[i];
+    plan_.forward(frame_.data());
+    const float a = (frames_ == 0) ? 1.0f : float(params_.alpha);
+    for (size_t k = 0; k < n; k++)
+    {
+        const float p = std::norm(frame_[k]) / norm_;
+        avg_[k] += a * (p - avg_[k]);
+    }
+    frames_++;
+}
+
+void psd_monitor::publish(int64_t index)
+{
+    psd_snapshot snap;
+    snap.frames = frames_;
+    snap.samples = samples_;
+    snap.index = index;
+    snap.rms_dbfs = to_db(interval_energy_ / double(interval_samples_));
+    snap.max_dbfs = to_db(interval_max_);
+    if (frames_ > 0)
+    {
+        const size_t n = avg_.size();
+        const size_t peak = size_t(std::max_element(avg_.begin(), avg_.end()) - avg_.begin());
+        snap.peak_bin = uint32_t(peak);
+        snap.peak_freq = double((peak < n / 2) ? int64_t(peak) : int64_t(peak) - int64_t(n)) * rate_ / double(n);
+        snap.peak_db = to_db(avg_[peak]);
+        work_ = avg_;
+        std::nth_element(work_.begin(), work_.begin() + n / 2, work_.end());
+        snap.floor_db = to_db(work_[n / 2]);
+    }
+    published_.store(snap);
+
+    interval_energy_ = 0;
+    interval_max_ = 0;
+    interval_samples_ = 0;
+}
+
+std::vector<float> psd_monitor::spectrum_db() const
+{
+    const size_t n = avg_.size();
+    std::vector<float> out(n);
+    for (size_t k = 0; k < n; k++)
+        out[k] = to_db(avg_[(k + n / 2) % n]);
+    return out;
+}
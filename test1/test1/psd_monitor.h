@@ -0,0 +1,82 @@
+#pragma once
+
+#include "fft.h"
+#include "metrics.h"
+#include "seqlock.h"
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Ƶ׼Ӳ
+struct psd_params
+{
+    size_t fft_size = 0;            // FFT2ݣ0ʾ
+    double alpha = 0.1;             // ָƽϵavg = (1 - alpha) * avg + alpha * |X|^2
+    double frames_per_sec = 200;    // ÿ֡FFTֻͳƹ
+    double publish_interval = 0.25; // յļ(룬)
+};
+
+// һηĿգʵλΪdBFS1ĸΪ0dBFS
+struct psd_snapshot
+{
+    uint64_t frames = 0;            // ƽFFT֡
+    uint64_t samples = 0;           // Ѵ
+    int64_t index = 0;              // һȫ±
+    uint32_t peak_bin = 0;          // ƽƵ㣨0Ϊֱfft_size/2ΪƵʣ
+    double peak_freq = 0;           // ƵƵʵƫ(Hz)
+    float peak_db = -200;           // Ƶƽ
+    float floor_db = -200;          // ƽ׵λΪ׹
+    float rms_dbfs = -200;          // RMS
+    float max_dbfs = -200;          // 䵥
+};
+
+// Ƶ/ʼӣ߳дfc32
+// ÿ㶼RMSͷֵʣFFTframes_per_secȡHann|X|^2ָƽ
+// ÿpublish_intervalͨ˳һοգߣͳ̵߳ȣ߳
+// process()ֻһ̵߳
+class psd_monitor
+{
+public:
+    psd_monitor(const psd_params& params, double rate);
+
+    // first_indexΪһȫ±ꣻʱ֡
+    void process(const std::complex<float>* samps, size_t nsamps, int64_t first_index);
+
+    // ȡһηĿգؿţ0ʾûз
+    uint64_t snapshot(psd_snapshot& out) const { return published_.load(out); }
+
+    size_t fft_size() const { return plan_.size(); }
+    double rate() const { return rate_; }
+
+    // ƽ(dBFS)Ƶʴ-rate/2rate/2Уֻɵprocess()̻߳
+    std::vector<float> spectrum_db() const;
+
+    counter gaps;                   // 벻Ĵ
+
+private:
+    void analyze_frame();
+    void publish(int64_t index);
+
+    const psd_params params_;
+    const double rate_;
+    fft_plan plan_;
+    std::vector<float> window_;
+    float norm_ = 1;                // ϵ͵ƽҵ|X|^2
+    size_t stride_ = 0;             // ֮֡
+    std::vector<std::complex<float>> frame_;
+    std::vector<float> avg_;
+    std::vector<float> work_;
+    size_t fill_ = 0;               // ǰ֡
+    size_t skip_ = 0;               // һ֡ʼǰҪ
+    int64_t next_index_ = -1;
+
+    uint64_t frames_ = 0;
+    uint64_t samples_ = 0;
+    double interval_energy_ = 0;
+    float interval_max_ = 0;
+    uint64_t interval_samples_ = 0;
+    uint64_t publish_samples_ = 0;  // ÿ
+
+    alignas(CACHE_LINE_SIZE) seqlock<psd_snapshot> published_;
+};
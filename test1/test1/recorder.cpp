@@ -0,0 +1,244 @@
+#include "recorder.h"
+#include "convert.h"
+#include "results.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // O_DIRECTҪַȺƫƶ룬ͳһҳ
+    const size_t IO_ALIGNMENT = 4096;
+
+    std::string sigmf_datatype(const std::string& cpu_format)
+    {
+        if (cpu_format == "sc16")
+            return "ci16_le";
+        if (cpu_format == "sc8")
+            return "ci8";
+        return "cf32_le";
+    }
+
+    std::string utc_now_iso8601()
+    {
+        const std::time_t now = std::time(nullptr);
+        std::tm utc;
+#if defined(_WIN32)
+        gmtime_s(&utc, &now);
+#else
+        gmtime_r(&now, &utc);
+#endif
+        std::ostringstream ss;
+        ss << std::put_time(&utc, "%Y-%m-%dT%H:%M:%SZ");
+        return ss.str();
+    }
+}
+
+recorder::recorder(const std::string& base, const sigmf_info& info, buffer_arena& arena,
+    const thread_placement& writer_placement)
+    : info_(info), bytes_per_samp_(bytes_per_sample(info.cpu_format)),
+    data_path_(base + ".sigmf-data"), meta_path_(base + ".sigmf-meta"), datetime_(utc_now_iso8601()),
+    full_(NUM_CHUNKS), free_(NUM_CHUNKS)
+{
+#if defined(_WIN32)
+    HANDLE h = CreateFileA(data_path_.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING, nullptr);
+    direct_ = (h != INVALID_HANDLE_VALUE);
+    if (!direct_)
+        h = CreateFileA(data_path_.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("Cannot open " + data_path_);
+    file_ = h;
+#else
+    // tmpfsļϵͳ֧O_DIRECT˻ͨд
+    fd_ = open(data_path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+    direct_ = (fd_ >= 0);
+    if (fd_ < 0 && errno == EINVAL)
+        fd_ = open(data_path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0)
+        throw std::runtime_error("Cannot open " + data_path_ + ": " + std::strerror(errno));
+#endif
+
+    for (size_t i = 0; i < NUM_CHUNKS; i++)
+    {
+        chunk* c = free_.acquire();
+        c->data = static_cast<char*>(arena.allocate(CHUNK_BYTES));
+        free_.publish();
+    }
+
+    writer_ = start_thread(writer_placement, &recorder::writer_loop, this);
+}
+
+recorder::~recorder()
+{
+    if (!finished_)
+        finish();
+}
+
+void recorder::write(const void* data, size_t nsamps, int64_t index)
+{
+    if (next_index_ < 0 || index != next_index_)
+        captures_.emplace_back(samples_, index);
+    next_index_ = index + int64_t(nsamps);
+    samples_ += nsamps;
+
+    const char* src = static_cast<const char*>(data);
+    size_t bytes = nsamps * bytes_per_samp_;
+    while (bytes > 0)
+    {
+        if (current_.data == nullptr)
+        {
+            // л嶼дʱȴ˵̸
+            chunk* c = free_.front();
+            if (c == nullptr)
+            {
+                ++stalls;
+                while ((c = free_.front()) == nullptr)
+                    std::this_thread::yield();
+            }
+            current_ = *c;
+            free_.pop();
+            fill_ = 0;
+        }
+
+        const size_t n = std::min(bytes, CHUNK_BYTES - fill_);
+        std::memcpy(current_.data + fill_, src, n);
+        fill_ += n;
+        src += n;
+        bytes -= n;
+        if (fill_ == CHUNK_BYTES)
+            submit(CHUNK_BYTES);
+    }
+}
+
+void recorder::submit(size_t bytes)
+{
+    // full_free_ͬȡλ
+    chunk* c = full_.acquire();
+    c->data = current_.data;
+    c->bytes = bytes;
+    full_.publish();
+    current_ = chunk();
+    fill_ = 0;
+}
+
+void recorder::writer_loop()
+{
+    uint64_t offset = 0;
+    while (true)
+    {
+        chunk* c = full_.front();
+        if (c == nullptr)
+        {
+            if (stop_)
+                break;
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            continue;
+        }
+
+        if (!failed_)
+        {
+#if defined(_WIN32)
+            DWORD written = 0;
+            const bool ok = WriteFile(static_cast<HANDLE>(file_), c->data, DWORD(c->bytes), &written, nullptr)
+                && written == c->bytes;
+#else
+            size_t done = 0;
+            while (done < c->bytes)
+            {
+                const ssize_t n = pwrite(fd_, c->data + done, c->bytes - done, off_t(offset + done));
+                if (n <= 0)
+                    break;
+                done += size_t(n);
+            }
+            const bool ok = (done == c->bytes);
+#endif
+            if (ok)
+            {
+                offset += c->bytes;
+                bytes_written += c->bytes;
+            }
+            else
+            {
+                failed_ = true;
+                std::cerr << "Write to " << data_path_ << " failed; recording stopped" << std::endl;
+            }
+        }
+
+        const chunk done = *c;
+        full_.pop();
+        chunk* f = free_.acquire();
+        *f = done;
+        free_.publish();
+    }
+}
+
+void recorder::finish()
+{
+    finished_ = true;
+
+    // һ鲹㵽볤дرǰضϻʵʳ
+    uint64_t total = samples_ * bytes_per_samp_;
+    if (current_.data != nullptr && fill_ > 0)
+    {
+        const size_t padded = (fill_ + IO_ALIGNMENT - 1) / IO_ALIGNMENT * IO_ALIGNMENT;
+        std::memset(current_.data + fill_, 0, padded - fill_);
+        submit(padded);
+    }
+    stop_ = true;
+    writer_.join();
+    // дʧʱļֻдĲ
+    total = std::min<uint64_t>(total, bytes_written);
+
+#if defined(_WIN32)
+    LARGE_INTEGER size;
+    size.QuadPart = LONGLONG(total);
+    SetFilePointerEx(static_cast<HANDLE>(file_), size, nullptr, FILE_BEGIN);
+    SetEndOfFile(static_cast<HANDLE>(file_));
+    CloseHandle(static_cast<HANDLE>(file_));
+#else
+    if (ftruncate(fd_, off_t(total)) != 0)
+        std::cerr << "Cannot truncate " << data_path_ << std::endl;
+    close(fd_);
+#endif
+
+    write_meta();
+}
+
+void recorder::write_meta() const
+{
+    std::ofstream meta(meta_path_);
+    meta << std::setprecision(15);
+    meta << "{\n  \"global\": {\n"
+        << "    \"core:datatype\": \"" << sigmf_datatype(info_.cpu_format) << "\",\n"
+        << "    \"core:sample_rate\": " << info_.sample_rate << ",\n"
+        << "    \"core:version\": \"1.0.0\",\n"
+        << "    \"core:hw\": \"" << json_escape(info_.hw) << "\",\n"
+        << "    \"core:recorder\": \"UHD TX/RX throughput test\"\n"
+        << "  },\n  \"captures\": [";
+    for (size_t i = 0; i < captures_.size(); i++)
+    {
+        meta << (i == 0 ? "\n" : ",\n")
+            << "    { \"core:sample_start\": " << captures_[i].first
+            << ", \"core:global_index\": " << captures_[i].second
+            << ", \"core:frequency\": " << info_.center_freq;
+        if (i == 0)
+            meta << ", \"core:datetime\": \"" << datetime_ << "\"";
+        meta << " }";
+    }
+    meta << "\n  ],\n  \"annotations\": []\n}\n";
+}
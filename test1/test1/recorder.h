@@ -0,0 +1,92 @@
+#pragma once
+
+#include "buffer_arena.h"
+#include "metrics.h"
+#include "spsc_ring.h"
+#include "thread_placement.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// ¼ļSigMFԪ
+struct sigmf_info
+{
+    std::string cpu_format;     // fc32/sc16/sc8Ӧcf32_le/ci16_le/ci8
+    double sample_rate = 0;
+    double center_freq = 0;
+    std::string hw;             // 豸ͺŵ
+};
+
+// ̣߰׷ӵҳĴ黺壬дһͽд߳
+// д߳O_DIRECTWindowsΪFILE_FLAG_NO_BUFFERING˳д룬黺ʹã
+// ̶ݱʱֻõߣ̣߳ȴ̲߳Ӱ
+// Ϊ<base>.sigmf-data<base>.sigmf-meta
+class recorder
+{
+public:
+    static constexpr size_t CHUNK_BYTES = size_t(8) << 20; // ÿд̵ĴС
+    static constexpr size_t NUM_CHUNKS = 4;
+
+    // arenaз䣬arenaԤarena_bytes()
+    recorder(const std::string& base, const sigmf_info& info, buffer_arena& arena,
+        const thread_placement& writer_placement);
+    ~recorder();
+
+    recorder(const recorder&) = delete;
+    recorder& operator=(const recorder&) = delete;
+
+    static size_t arena_bytes() { return NUM_CHUNKS * buffer_arena::footprint(CHUNK_BYTES); }
+
+    // ׷nsamps㣻indexΪһȫ±꣬ʱԪ¿һcapture
+    // ֻһ̵߳
+    void write(const void* data, size_t nsamps, int64_t index);
+
+    // дʣݡضϵʵʳȲдԪݣwrite()߳̽
+    void finish();
+
+    const std::string& data_path() const { return data_path_; }
+    bool direct_io() const { return direct_; }
+
+    alignas(CACHE_LINE_SIZE) counter bytes_written; // д߳д
+    alignas(CACHE_LINE_SIZE) counter stalls;        // ߵȴлĴ
+
+private:
+    struct chunk
+    {
+        char* data = nullptr;
+        size_t bytes = 0;
+    };
+
+    void writer_loop();
+    void submit(size_t bytes);
+    void write_meta() const;
+
+    const sigmf_info info_;
+    const size_t bytes_per_samp_;
+    std::string data_path_;
+    std::string meta_path_;
+    std::string datetime_;
+    bool direct_ = false;
+#if defined(_WIN32)
+    void* file_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+
+    spsc_ring<chunk> full_;     //  -> д߳
+    spsc_ring<chunk> free_;     // д߳ -> 
+    chunk current_;
+    size_t fill_ = 0;
+
+    uint64_t samples_ = 0;      // ׷ӵ
+    int64_t next_index_ = -1;
+    std::vector<std::pair<uint64_t, int64_t>> captures_; // (ļе±, ȫ±)
+
+    std::atomic<bool> stop_{ false };
+    std::atomic<bool> failed_{ false };
+    std::thread writer_;
+    bool finished_ = false;
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+// м̴inΪյnsamps(cpu_format)дoutҪ͵
+// outտͬ0ʾһ鲻
+typedef std::function<size_t(const char* in, char* out, size_t nsamps)> relay_fn;
+
+// ȫ˫м̣տ龭ԡʱ + offsetʱ
+struct relay_params
+{
+    double offset = 0;              // ʱԽʱĹ̶ӳ()0ʾ
+    std::string process = "copy";   // ôcopygain
+    double gain = 1.0;              // gain
+    relay_fn callback;              // ǿʱôstd::functionãֻɴã
+
+    bool enabled() const { return offset > 0; }
+};
+
+// ôǿĺrelay_workerģʵÿûмӵ
+// ԭת
+class relay_copy
+{
+public:
+    explicit relay_copy(size_t bytes_per_samp) : bytes_per_samp_(bytes_per_samp) {}
+
+    size_t operator()(const char* in, char* out, size_t nsamps) const
+    {
+        std::memcpy(out, in, nsamps * bytes_per_samp_);
+        return nsamps;
+    }
+
+private:
+    size_t bytes_per_samp_;
+};
+
+// Թ̶棬sc16/sc8ʱ
+class relay_gain
+{
+public:
+    relay_gain(float gain, const std::string& cpu_format) : gain_(gain)
+    {
+        if (cpu_format == "fc32")
+            format_ = FC32;
+        else if (cpu_format == "sc16")
+            format_ = SC16;
+        else if (cpu_format == "sc8")
+            format_ = SC8;
+        else
+            throw std::invalid_argument("relay gain does not support format " + cpu_format);
+    }
+
+    size_t operator()(const char* in, char* out, size_t nsamps) const
+    {
+        switch (format_)
+        {
+        case FC32:
+            scale(reinterpret_cast<const float*>(in), reinterpret_cast<float*>(out), 2 * nsamps);
+            break;
+        case SC16:
+            scale(reinterpret_cast<const int16_t*>(in), reinterpret_cast<int16_t*>(out), 2 * nsamps);
+            break;
+        case SC8:
+            scale(reinterpret_cast<const int8_t*>(in), reinterpret_cast<int8_t*>(out), 2 * nsamps);
+            break;
+        }
+        return nsamps;
+    }
+
+private:
+    enum format_t { FC32, SC16, SC8 };
+
+    void scale(const float* in, float* out, size_t n) const
+    {
+        for (size_t i = 0; i < n; i++)
+            out[i] = in[i] * gain_;
+    }
+
+    template <typename T>
+    void scale(const T* in, T* out, size_t n) const
+    {
+        const float lo = float(std::numeric_limits<T>::min());
+        const float hi = float(std::numeric_limits<T>::max());
+        for (size_t i = 0; i < n; i++)
+            out[i] = T(std::lrint(std::min(hi, std::max(lo, float(in[i]) * gain_))));
+    }
+
+    float gain_;
+    format_t format_ = FC32;
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "relay.h"
+#include "rx_stream.h"
+#include "thread_placement.h"
+#include "tx_stream.h"
+#include <uhd/types/metadata.hpp>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+// м̣߳Խ̺ͨ߳ͷͨķ̣߳ӽնȡ飬
+// processԡʱ + cfg.relay.offsetʱ
+// processֵ߳Уôʵȫrelay_fnstd::function
+// һ㵽ʱ豸ʱԼΪtime + num_samps/rate֮󾭹ʱȥΪsend()ʱ豸ʱ䣻
+// ʱbudget_usedoffsetΪٵʱδ룬豸ϱʱʵʳٵİ
+// relay_done֮ȡʣĿ飬ٷEOB
+template <typename Process>
+void relay_worker(rx_channel& rx, tx_channel& tx, const test_config& cfg, const std::atomic<bool>& relay_done,
+    Process process)
+{
+    uhd::tx_metadata_t md;
+    md.start_of_burst = true;
+    md.end_of_burst = false;
+    md.has_time_spec = true;
+
+    const uhd::time_spec_t offset(cfg.relay.offset);
+    const int64_t offset_ns = std::llround(cfg.relay.offset * 1e9);
+    // ݱȷʱǰoffset豸豸ʱsend()Լoffset
+    const double timeout = cfg.relay.offset + 0.1;
+    const int64_t cpu_start = thread_cpu_ns();
+
+    while (true)
+    {
+        rx_block* blk = rx.ring.front();
+        if (blk == nullptr)
+        {
+            if (relay_done && rx.ring.size() == 0)
+                break;
+            std::this_thread::yield();
+            continue;
+        }
+        rx.consumer.ring_high_water.update_max(rx.ring.size());
+
+        const auto process_start = std::chrono::steady_clock::now();
+        const size_t nsamps = process(static_cast<const char*>(blk->buff), tx.relay_buff, blk->num_samps);
+        const auto call_start = std::chrono::steady_clock::now();
+        tx.relay.process_ns += uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            call_start - process_start).count());
+        ++tx.relay.blocks;
+
+        if (nsamps == 0)
+            ++tx.relay.skipped;
+        else
+        {
+            md.time_spec = blk->time + offset;
+            const size_t num_sent = tx.stream->send(tx.relay_buff, nsamps, md, timeout);
+            const auto call_end = std::chrono::steady_clock::now();
+            const uint64_t call_ns = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                call_end - call_start).count());
+            tx.metrics.send_latency.record(call_ns);
+            ++tx.metrics.calls;
+            tx.metrics.call_ns += call_ns;
+            if (num_sent < nsamps)
+                ++tx.metrics.errors;
+            tx.metrics.samples += num_sent;
+            md.start_of_burst = false;
+
+            const int64_t used = std::llround(double(blk->num_samps) / rx.rate * 1e9)
+                + (std::chrono::duration_cast<std::chrono::nanoseconds>(call_end.time_since_epoch()).count()
+                    - blk->host_ns);
+            tx.relay.budget_used.record(uint64_t(std::max<int64_t>(0, used)));
+            if (used > offset_ns)
+                ++tx.relay.late;
+        }
+
+        rx.consumer.consumed_samples += blk->num_samps;
+        rx.ring.pop();
+    }
+
+    md.end_of_burst = true;
+    md.has_time_spec = false;
+    tx.stream->send("", 0, md);
+    tx.metrics.cpu_ns += uint64_t(thread_cpu_ns() - cpu_start);
+}
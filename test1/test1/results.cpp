@@ -0,0 +1,207 @@
+#include "results.h"
+#include "convert.h"
+#include "signal_gen.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/utsname.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // šŻеֶμţڲд
+    std::string csv_escape(const std::string& s)
+    {
+        if (s.find_first_of(",\"\r\n") == std::string::npos)
+            return s;
+        std::string out = "\"";
+        for (char c : s)
+        {
+            if (c == '"')
+                out += '"';
+            out += c;
+        }
+        return out + "\"";
+    }
+
+    // չǰ¼ͣresults.csv -> results.summary.csv
+    std::string csv_path(const std::string& path, const std::string& type)
+    {
+        const size_t dot = path.find_last_of('.');
+        const size_t slash = path.find_last_of("/\\");
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+            return path + "." + type + ".csv";
+        return path.substr(0, dot) + "." + type + path.substr(dot);
+    }
+
+    std::string cpu_model()
+    {
+#if defined(_WIN32)
+        char buf[256];
+        const DWORD n = GetEnvironmentVariableA("PROCESSOR_IDENTIFIER", buf, sizeof(buf));
+        return (n > 0 && n < sizeof(buf)) ? std::string(buf, n) : "unknown";
+#else
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+        while (std::getline(cpuinfo, line))
+        {
+            if (line.compare(0, 10, "model name") == 0)
+            {
+                const size_t colon = line.find(':');
+                if (colon != std::string::npos)
+                    return line.substr(line.find_first_not_of(" \t", colon + 1));
+            }
+        }
+        return "unknown";
+#endif
+    }
+}
+
+std::string json_escape(const std::string& s)
+{
+    std::string out;
+    for (char c : s)
+    {
+        switch (c)
+        {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            }
+            else
+                out += c;
+        }
+    }
+    return out;
+}
+
+void result_record::add(const std::string& key, double value)
+{
+    // JSONûinf/nanдnull
+    if (!std::isfinite(value))
+    {
+        fields_.push_back({ key, "null", false });
+        return;
+    }
+    std::ostringstream ss;
+    ss << std::setprecision(12) << value;
+    fields_.push_back({ key, ss.str(), false });
+}
+
+results_writer::results_writer(const std::string& path, const std::string& format)
+    : path_(path), csv_(format == "csv")
+{
+    if (format != "json" && format != "csv")
+        throw std::runtime_error("Unsupported results format: " + format);
+    if (!csv_)
+    {
+        // ׷д룬еļ¼ռͬһļ
+        json_.open(path, std::ios::app);
+        if (!json_)
+            throw std::runtime_error("Cannot open " + path);
+    }
+}
+
+void results_writer::write(const std::string& type, const result_record& record)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!csv_)
+    {
+        json_ << "{\"type\":\"" << json_escape(type) << "\"";
+        for (const auto& f : record.fields())
+        {
+            json_ << ",\"" << json_escape(f.key) << "\":";
+            if (f.quoted)
+                json_ << "\"" << json_escape(f.value) << "\"";
+            else
+                json_ << f.value;
+        }
+        json_ << "}\n" << std::flush;
+        return;
+    }
+
+    csv_file& file = csv_files_[type];
+    if (!file.out)
+    {
+        const std::string p = csv_path(path_, type);
+        file.out.reset(new std::ofstream(p));
+        if (!*file.out)
+            throw std::runtime_error("Cannot open " + p);
+    }
+    std::vector<std::string> header;
+    for (const auto& f : record.fields())
+        header.push_back(f.key);
+    if (header != file.header)
+    {
+        std::string line = "type";
+        for (const auto& key : header)
+            line += "," + csv_escape(key);
+        *file.out << line << "\n";
+        file.header = header;
+    }
+    std::string line = csv_escape(type);
+    for (const auto& f : record.fields())
+        line += "," + ((f.value == "null") ? std::string() : csv_escape(f.value));
+    *file.out << line << "\n" << std::flush;
+}
+
+void add_host_info(result_record& record)
+{
+#if defined(_WIN32)
+    char name[MAX_COMPUTERNAME_LENGTH + 1];
+    DWORD len = sizeof(name);
+    record.add("host.name", GetComputerNameA(name, &len) ? std::string(name, len) : std::string("unknown"));
+    record.add("host.os", "Windows");
+#else
+    char name[256] = {};
+    record.add("host.name", gethostname(name, sizeof(name) - 1) == 0 ? std::string(name) : std::string("unknown"));
+    utsname u;
+    if (uname(&u) == 0)
+        record.add("host.os", std::string(u.sysname) + " " + u.release + " " + u.machine);
+    else
+        record.add("host.os", "unknown");
+#endif
+    record.add("host.cpu", cpu_model());
+    record.add("host.cpus", uint64_t(std::thread::hardware_concurrency()));
+#if defined(_MSC_VER)
+    record.add("build.compiler", "MSVC " + std::to_string(_MSC_VER));
+#elif defined(__VERSION__)
+    record.add("build.compiler", __VERSION__);
+#endif
+    record.add("build.convert", convert_impl_name());
+    record.add("build.signal", signal_impl_name());
+}
+
+std::string utc_timestamp()
+{
+    const auto now = std::chrono::system_clock::now();
+    const std::time_t t = std::chrono::system_clock::to_time_t(now);
+    const int ms = int(std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000);
+    std::tm utc;
+#if defined(_WIN32)
+    gmtime_s(&utc, &t);
+#else
+    gmtime_r(&t, &utc);
+#endif
+    std::ostringstream ss;
+    ss << std::put_time(&utc, "%Y-%m-%dT%H:%M:%S") << "." << std::setw(3) << std::setfill('0') << ms << "Z";
+    return ss.str();
+}
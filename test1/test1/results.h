@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// JSONַݵת壨ţַд\u00XX
+std::string json_escape(const std::string& s);
+
+// һṹ¼˳򱣴ļֵԣ"."ֲ㣬"tx0.samples"
+class result_record
+{
+public:
+    void add(const std::string& key, const std::string& value) { fields_.push_back({ key, value, true }); }
+    void add(const std::string& key, const char* value) { add(key, std::string(value)); }
+    void add(const std::string& key, bool value) { fields_.push_back({ key, value ? "true" : "false", false }); }
+    void add(const std::string& key, double value);
+    void add(const std::string& key, uint64_t value) { fields_.push_back({ key, std::to_string(value), false }); }
+    void add(const std::string& key, int64_t value) { fields_.push_back({ key, std::to_string(value), false }); }
+    void add(const std::string& key, int value) { add(key, int64_t(value)); }
+
+    // ׷һ¼ȫֶΣÿ¼ǰԪݣ
+    void append(const result_record& other) { fields_.insert(fields_.end(), other.fields_.begin(), other.fields_.end()); }
+
+    struct field
+    {
+        std::string key;
+        std::string value;
+        bool quoted;        // JSONǷΪַ
+    };
+    const std::vector<field>& fields() const { return fields_; }
+
+private:
+    std::vector<field> fields_;
+};
+
+// jsonΪÿһ(JSON lines)csv¼ͷļ
+// results.csvдresults.interval.csvresults.summary.csvֶα仯ʱдͷ
+// write()ɶ̵߳
+class results_writer
+{
+public:
+    results_writer(const std::string& path, const std::string& format);
+
+    // typeд¼"type"ֶΣCSVʱļ
+    void write(const std::string& type, const result_record& record);
+
+private:
+    struct csv_file
+    {
+        std::unique_ptr<std::ofstream> out;
+        std::vector<std::string> header;
+    };
+
+    std::string path_;
+    bool csv_;
+    std::ofstream json_;
+    std::map<std::string, csv_file> csv_files_;
+    std::mutex mutex_;
+};
+
+// ϵͳCPUͺźͺ
+void add_host_info(result_record& record);
+
+// ǰUTCʱ䣬ISO 8601ʽȷ
+std::string utc_timestamp();
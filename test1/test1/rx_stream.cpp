@@ -0,0 +1,208 @@
+#include "rx_stream.h"
+#include "convert.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+void count_rx_error(rx_channel& rx, const uhd::rx_metadata_t& md)
+{
+    switch (md.error_code)
+    {
+    case uhd::rx_metadata_t::ERROR_CODE_OVERFLOW:
+        // out_of_sequenceʾ㶪ȡ
+        if (md.out_of_sequence)
+            ++rx.metrics.seq_errors;
+        else
+            ++rx.metrics.overflows;
+        break;
+    case uhd::rx_metadata_t::ERROR_CODE_TIMEOUT:
+        ++rx.metrics.timeouts;
+        break;
+    case uhd::rx_metadata_t::ERROR_CODE_LATE_COMMAND:
+        ++rx.metrics.late_commands;
+        break;
+    default:
+        ++rx.metrics.other_errors;
+        break;
+    }
+}
+
+void restart_rx_stream(uhd::usrp::multi_usrp::sptr usrp, rx_channel& rx,
+    char* scratch, size_t nsamps, double delay)
+{
+    rx.stream->issue_stream_cmd(uhd::stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS);
+
+    uhd::rx_metadata_t md;
+    for (size_t i = 0; i < 1000; i++)
+    {
+        rx.stream->recv(scratch, nsamps, md, 0.01);
+        if (md.error_code == uhd::rx_metadata_t::ERROR_CODE_TIMEOUT)
+            break;
+    }
+
+    uhd::stream_cmd_t cmd(uhd::stream_cmd_t::STREAM_MODE_START_CONTINUOUS);
+    cmd.stream_now = false;
+    cmd.time_spec = usrp->get_time_now(rx.mboard) + uhd::time_spec_t(delay);
+    rx.stream->issue_stream_cmd(cmd);
+    ++rx.metrics.restarts;
+}
+
+namespace
+{
+    // һ֮ȵʱ䣺ͣ豸ʹе;ͨڼڵ
+    const double DRAIN_TIMEOUT = 0.02;
+
+    // һ뻷ζУʱmd.error_codeΪNONE0
+    size_t receive_block(rx_channel& rx, const test_config& cfg, double timeout, uhd::rx_metadata_t& md)
+    {
+        // 㿽ģʽȴӶȡвλrecvֱдλ
+        rx_block* blk = cfg.zero_copy ? rx.ring.acquire() : nullptr;
+        char* recv_buff = (blk != nullptr) ? blk->buff : rx.staging;
+
+        const auto call_start = std::chrono::steady_clock::now();
+        size_t num_rx = rx.stream->recv(recv_buff, rx.batch, md, timeout); // 
+        const auto call_end = std::chrono::steady_clock::now();
+        const uint64_t call_ns = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            call_end - call_start).count());
+        rx.metrics.recv_latency.record(call_ns);
+        ++rx.metrics.calls;
+        rx.metrics.call_ns += call_ns;
+
+        if (md.error_code != uhd::rx_metadata_t::ERROR_CODE_NONE)
+            return 0;
+
+        rx.metrics.samples += num_rx;
+
+        // ʱ飬̲߳ȴ
+        if (!cfg.zero_copy)
+        {
+            blk = rx.ring.acquire();
+            if (blk != nullptr)
+                std::memcpy(blk->buff, rx.staging, num_rx * cfg.bytes_per_samp);
+        }
+        if (blk == nullptr)
+        {
+            ++rx.metrics.drops;
+            return num_rx;
+        }
+
+        // λУpop()ʱ黹
+        blk->num_samps = num_rx;
+        blk->time = md.time_spec;
+        blk->host_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(call_end.time_since_epoch()).count();
+        rx.ring.publish();
+        return num_rx;
+    }
+}
+
+void rx_worker(uhd::usrp::multi_usrp::sptr usrp, rx_channel& rx, const test_config& cfg,
+    const start_schedule& start, const std::atomic<bool>& rx_done)
+{
+    const double default_timeout = 0.1;
+    double timeout = default_timeout;
+    size_t error_burst = 0;
+    const int64_t cpu_start = thread_cpu_ns();
+
+    // ʱʱһrecvҪȵʼʱ
+    uhd::stream_cmd_t rx_cmd(uhd::stream_cmd_t::STREAM_MODE_START_CONTINUOUS);
+    rx_cmd.stream_now = !start.timed;
+    rx_cmd.time_spec = start.device_time;
+    if (start.timed)
+        timeout += std::max(0.0, std::chrono::duration<double>(
+            start.host_time - std::chrono::steady_clock::now()).count());
+    rx.stream->issue_stream_cmd(rx_cmd);
+
+    while (!rx_done)
+    {
+        uhd::rx_metadata_t rx_md;
+        receive_block(rx, cfg, timeout, rx_md);
+        if (rx_md.error_code != uhd::rx_metadata_t::ERROR_CODE_NONE)
+        {
+            count_rx_error(rx, rx_md);
+
+            // ﵽֵʱһrecvҪȵʱʱ
+            if (cfg.rx_restart_errors > 0 && ++error_burst >= cfg.rx_restart_errors)
+            {
+                restart_rx_stream(usrp, rx, rx.staging, rx.batch, cfg.rx_restart_delay);
+                timeout = default_timeout + cfg.rx_restart_delay;
+                error_burst = 0;
+            }
+            continue;
+        }
+        error_burst = 0;
+        timeout = default_timeout;
+    }
+
+    // ͣſ;İճ뻷ζвֱʱͻ򳬹shutdown_timeout
+    rx.stream->issue_stream_cmd(uhd::stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS);
+    const auto drain_deadline = std::chrono::steady_clock::now()
+        + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(cfg.shutdown_timeout));
+    while (std::chrono::steady_clock::now() < drain_deadline)
+    {
+        uhd::rx_metadata_t md;
+        const size_t n = receive_block(rx, cfg, DRAIN_TIMEOUT, md);
+        if (md.error_code == uhd::rx_metadata_t::ERROR_CODE_TIMEOUT)
+            break;
+        if (md.error_code != uhd::rx_metadata_t::ERROR_CODE_NONE)
+        {
+            count_rx_error(rx, md);
+            continue;
+        }
+        rx.metrics.drained_samples += n;
+        if (md.end_of_burst)
+            break;
+    }
+    rx.metrics.cpu_ns += uint64_t(thread_cpu_ns() - cpu_start);
+}
+
+void consumer_worker(rx_channel& rx, const test_config& cfg, const start_schedule& start,
+    const std::atomic<bool>& consumer_done)
+{
+
+    while (true)
+    {
+        rx_block* blk = rx.ring.front();
+        if (blk == nullptr)
+        {
+            if (consumer_done && rx.ring.size() == 0)
+                break;
+            std::this_thread::yield();
+            continue;
+        }
+        rx.consumer.ring_high_water.update_max(rx.ring.size());
+
+        // طDSPƵ׼Ҫfc32㣬sc16/sc8ʱͬת
+        const std::complex<float>* fc32 = reinterpret_cast<const std::complex<float>*>(blk->buff);
+        const bool need_fc32 = rx.loopback != nullptr || rx.dsp != nullptr || rx.psd != nullptr;
+        if (cfg.convert || (need_fc32 && cfg.cpu_format != "fc32"))
+        {
+            if (cfg.cpu_format == "sc16")
+                convert_sc16_to_fc32(reinterpret_cast<const std::complex<int16_t>*>(blk->buff),
+                    rx.fc32_buff, blk->num_samps);
+            else
+                convert_sc8_to_fc32(reinterpret_cast<const std::complex<int8_t>*>(blk->buff),
+                    rx.fc32_buff, blk->num_samps);
+            fc32 = rx.fc32_buff;
+            rx.consumer.converted_samples += blk->num_samps;
+        }
+
+        // ʱȫ±꣬ڷȱ
+        if (need_fc32 || rx.rec != nullptr)
+        {
+            const int64_t first_index = std::llround((blk->time - start.device_time).get_real_secs() * rx.rate);
+            if (rx.loopback != nullptr)
+                rx.loopback->process(fc32, blk->num_samps, first_index, blk->host_ns);
+            if (rx.rec != nullptr)
+                rx.rec->write(blk->buff, blk->num_samps, first_index);
+            if (rx.dsp != nullptr)
+                rx.dsp->submit(fc32, blk->num_samps, first_index);
+            if (rx.psd != nullptr)
+                rx.psd->process(fc32, blk->num_samps, first_index);
+        }
+
+        rx.consumer.consumed_samples += blk->num_samps;
+        rx.ring.pop();
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "buffer_arena.h"
+#include "dsp_stage.h"
+#include "loopback.h"
+#include "metrics.h"
+#include "psd_monitor.h"
+#include "recorder.h"
+#include "spsc_ring.h"
+#include "stream_config.h"
+#include <uhd/stream.hpp>
+#include <uhd/types/metadata.hpp>
+#include <uhd/usrp/multi_usrp.hpp>
+#include <atomic>
+#include <complex>
+#include <memory>
+#include <vector>
+
+const size_t RX_RING_SLOTS = 64;      // ջζвλ
+
+// ջζеһݿ飬cpu_formatԭʼ㣬buffer_arena
+struct rx_block
+{
+    char* buff = nullptr;
+    size_t num_samps = 0;
+    uhd::time_spec_t time;          // һ豸ʱ
+    int64_t host_ns = 0;            // recv()ʱʱ(steady_clock)
+};
+
+// ͨrecv߳ -> ζ -> ߳
+struct rx_channel
+{
+    // вλݴת嶼arenaз
+    rx_channel(size_t chan_, size_t mboard_, uhd::rx_streamer::sptr stream_, buffer_arena& arena,
+        size_t block_bytes, size_t fc32_samps)
+        : chan(chan_), mboard(mboard_), stream(stream_), ring(RX_RING_SLOTS)
+    {
+        ring.for_each_slot([&](rx_block& blk) { blk.buff = static_cast<char*>(arena.allocate(block_bytes)); });
+        staging = static_cast<char*>(arena.allocate(block_bytes));
+        fc32_buff = static_cast<std::complex<float>*>(arena.allocate(fc32_samps * sizeof(std::complex<float>)));
+    }
+
+    // һͨarenaռõĿռ
+    static size_t arena_bytes(size_t block_bytes, size_t fc32_samps)
+    {
+        return (RX_RING_SLOTS + 1) * buffer_arena::footprint(block_bytes)
+            + buffer_arena::footprint(fc32_samps * sizeof(std::complex<float>));
+    }
+
+    size_t chan;
+    size_t mboard;
+    uhd::rx_streamer::sptr stream;
+    spsc_ring<rx_block> ring;
+    char* staging = nullptr;      // ģʽµĽջ壻㿽ģʽ½ڶʱڶ
+    std::complex<float>* fc32_buff = nullptr; // ̵߳ת
+    loopback_analyzer* loopback = nullptr;    // ģʽ̷߳
+    recorder* rec = nullptr;                  // ¼ʱ߳д
+    dsp_stage* dsp = nullptr;                 // DSPʱ߳ύ
+    psd_monitor* psd = nullptr;               // Ƶ׼ӣ̴߳
+    double rate = 0;                          // ʵʲ
+    size_t batch = 0;                         // ÿrecv()һ
+    rx_metrics metrics;           // recv߳д
+    consumer_metrics consumer;    // ߳д
+};
+
+typedef std::vector<std::unique_ptr<rx_channel>> rx_channels_t;
+
+// ͼֻ±̵߳ļ飬·ϲκ
+void count_rx_error(rx_channel& rx, const uhd::rx_metadata_t& md);
+
+// ֹͣ;ݺdelayʱ
+void restart_rx_stream(uhd::usrp::multi_usrp::sptr usrp, rx_channel& rx,
+    char* scratch, size_t nsamps, double delay);
+
+// ֻ̣߳ݷ뻷ζУrx_doneͣ;İſյ
+void rx_worker(uhd::usrp::multi_usrp::sptr usrp, rx_channel& rx, const test_config& cfg,
+    const start_schedule& start, const std::atomic<bool>& rx_done);
+
+// ̣߳ӻζȡ߽
+void consumer_worker(rx_channel& rx, const test_config& cfg, const start_schedule& start,
+    const std::atomic<bool>& consumer_done);
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+// д˳дߴӲȴߴӲдߣдһʱض
+// дȰѰ汾ŸΪдٸΪżǰζͬһż汾Ų
+// ݰֽڿTƽ
+template <typename T>
+class seqlock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "seqlock needs a trivially copyable type");
+
+public:
+    seqlock() { std::memset(static_cast<void*>(&value_), 0, sizeof(T)); }
+
+    seqlock(const seqlock&) = delete;
+    seqlock& operator=(const seqlock&) = delete;
+
+    // ֻһ̵߳
+    void store(const T& v)
+    {
+        const uint64_t s = seq_.load(std::memory_order_relaxed);
+        seq_.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(static_cast<void*>(&value_), &v, sizeof(T));
+        seq_.store(s + 2, std::memory_order_release);
+    }
+
+    // ߳̿ɵãضİ汾0ʾûд
+    uint64_t load(T& out) const
+    {
+        while (true)
+        {
+            const uint64_t s1 = seq_.load(std::memory_order_acquire);
+            if (s1 & 1)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            std::memcpy(static_cast<void*>(&out), &value_, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == s1)
+                return s1 / 2;
+        }
+    }
+
+private:
+    std::atomic<uint64_t> seq_{ 0 };
+    T value_;
+};
@@ -0,0 +1,347 @@
+#include "signal_gen.h"
+#include "convert.h"
+#include "loopback.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SIGNAL_USE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SIGNAL_USE_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SIGNAL_USE_NEON
+#endif
+
+namespace
+{
+    // ̶8·ʵͬУW·һ鲢и
+    const size_t LANES = 8;
+    // ÿɵں˶鴦Ҫβ
+    const size_t BLOCK = 1024;
+
+    // ָС
+#if defined(SIGNAL_USE_AVX2)
+    const size_t W = 8;
+    typedef __m256i vu;
+    typedef __m256 vf;
+    inline vu load_u(const uint32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    inline void store_u(uint32_t* p, vu a) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), a); }
+    inline vu set_u(uint32_t c) { return _mm256_set1_epi32(int(c)); }
+    inline vu xor_u(vu a, vu b) { return _mm256_xor_si256(a, b); }
+    inline vu or_u(vu a, vu b) { return _mm256_or_si256(a, b); }
+    inline vu shl(vu a, int k) { return _mm256_sll_epi32(a, _mm_cvtsi32_si128(k)); }
+    inline vu shr(vu a, int k) { return _mm256_srl_epi32(a, _mm_cvtsi32_si128(k)); }
+    inline vf load_f(const float* p) { return _mm256_loadu_ps(p); }
+    inline void store_f(float* p, vf a) { _mm256_storeu_ps(p, a); }
+    inline vf set_f(float c) { return _mm256_set1_ps(c); }
+    inline vf add(vf a, vf b) { return _mm256_add_ps(a, b); }
+    inline vf sub(vf a, vf b) { return _mm256_sub_ps(a, b); }
+    inline vf mul(vf a, vf b) { return _mm256_mul_ps(a, b); }
+    inline vf min_f(vf a, vf b) { return _mm256_min_ps(a, b); }
+    inline vf max_f(vf a, vf b) { return _mm256_max_ps(a, b); }
+    inline vf as_float(vu a) { return _mm256_castsi256_ps(a); }
+    inline vf to_float(vu a) { return _mm256_cvtepi32_ps(a); } // зת
+#elif defined(SIGNAL_USE_SSE2)
+    const size_t W = 4;
+    typedef __m128i vu;
+    typedef __m128 vf;
+    inline vu load_u(const uint32_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    inline void store_u(uint32_t* p, vu a) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a); }
+    inline vu set_u(uint32_t c) { return _mm_set1_epi32(int(c)); }
+    inline vu xor_u(vu a, vu b) { return _mm_xor_si128(a, b); }
+    inline vu or_u(vu a, vu b) { return _mm_or_si128(a, b); }
+    inline vu shl(vu a, int k) { return _mm_sll_epi32(a, _mm_cvtsi32_si128(k)); }
+    inline vu shr(vu a, int k) { return _mm_srl_epi32(a, _mm_cvtsi32_si128(k)); }
+    inline vf load_f(const float* p) { return _mm_loadu_ps(p); }
+    inline void store_f(float* p, vf a) { _mm_storeu_ps(p, a); }
+    inline vf set_f(float c) { return _mm_set1_ps(c); }
+    inline vf add(vf a, vf b) { return _mm_add_ps(a, b); }
+    inline vf sub(vf a, vf b) { return _mm_sub_ps(a, b); }
+    inline vf mul(vf a, vf b) { return _mm_mul_ps(a, b); }
+    inline vf min_f(vf a, vf b) { return _mm_min_ps(a, b); }
+    inline vf max_f(vf a, vf b) { return _mm_max_ps(a, b); }
+    inline vf as_float(vu a) { return _mm_castsi128_ps(a); }
+    inline vf to_float(vu a) { return _mm_cvtepi32_ps(a); }
+#elif defined(SIGNAL_USE_NEON)
+    const size_t W = 4;
+    typedef uint32x4_t vu;
+    typedef float32x4_t vf;
+    inline vu load_u(const uint32_t* p) { return vld1q_u32(p); }
+    inline void store_u(uint32_t* p, vu a) { vst1q_u32(p, a); }
+    inline vu set_u(uint32_t c) { return vdupq_n_u32(c); }
+    inline vu xor_u(vu a, vu b) { return veorq_u32(a, b); }
+    inline vu or_u(vu a, vu b) { return vorrq_u32(a, b); }
+    inline vu shl(vu a, int k) { return vshlq_u32(a, vdupq_n_s32(k)); }
+    inline vu shr(vu a, int k) { return vshlq_u32(a, vdupq_n_s32(-k)); }
+    inline vf load_f(const float* p) { return vld1q_f32(p); }
+    inline void store_f(float* p, vf a) { vst1q_f32(p, a); }
+    inline vf set_f(float c) { return vdupq_n_f32(c); }
+    inline vf add(vf a, vf b) { return vaddq_f32(a, b); }
+    inline vf sub(vf a, vf b) { return vsubq_f32(a, b); }
+    inline vf mul(vf a, vf b) { return vmulq_f32(a, b); }
+    inline vf min_f(vf a, vf b) { return vminq_f32(a, b); }
+    inline vf max_f(vf a, vf b) { return vmaxq_f32(a, b); }
+    inline vf as_float(vu a) { return vreinterpretq_f32_u32(a); }
+    inline vf to_float(vu a) { return vcvtq_f32_s32(vreinterpretq_s32_u32(a)); }
+#else
+    const size_t W = 1;
+    typedef uint32_t vu;
+    typedef float vf;
+    inline vu load_u(const uint32_t* p) { return *p; }
+    inline void store_u(uint32_t* p, vu a) { *p = a; }
+    inline vu set_u(uint32_t c) { return c; }
+    inline vu xor_u(vu a, vu b) { return a ^ b; }
+    inline vu or_u(vu a, vu b) { return a | b; }
+    inline vu shl(vu a, int k) { return a << k; }
+    inline vu shr(vu a, int k) { return a >> k; }
+    inline vf load_f(const float* p) { return *p; }
+    inline void store_f(float* p, vf a) { *p = a; }
+    inline vf set_f(float c) { return c; }
+    inline vf add(vf a, vf b) { return a + b; }
+    inline vf sub(vf a, vf b) { return a - b; }
+    inline vf mul(vf a, vf b) { return a * b; }
+    inline vf min_f(vf a, vf b) { return std::min(a, b); }
+    inline vf max_f(vf a, vf b) { return std::max(a, b); }
+    inline vf as_float(vu a) { float f; std::memcpy(&f, &a, sizeof(f)); return f; }
+    inline vf to_float(vu a) { return float(int32_t(a)); }
+#endif
+
+    // 23λŽβõ[1, 2)ϵľȷֲ
+    inline vf unit_interval(vu r) { return as_float(or_u(shr(r, 9), set_u(0x3f800000u))); }
+
+    // ÿȡĸbitsλӳ䵽2^bitsȼƽ[-amp, amp]
+    void qam_levels(const uint32_t* r, float* out, size_t n, int bits, float amp)
+    {
+        const vf step = set_f(2.0f * amp / float((1u << bits) - 1));
+        const vf offset = set_f(amp);
+        for (size_t i = 0; i < n; i += W)
+            store_f(out + i, sub(mul(to_float(shr(load_u(r + i), 32 - bits)), step), offset));
+    }
+
+    // out = amp * sin(2*pi*phase/2^32)
+    // λ۵[-1/4, 1/4]ܣ11̩նʽԼ6e-8
+    // λתfloatʱֻ24λɴ˴Լ4e-6
+    void sin_turns(const uint32_t* phase, float* out, size_t n, float amp)
+    {
+        const vf turns = set_f(1.0f / 4294967296.0f);
+        const vf two_pi = set_f(6.28318530718f);
+        for (size_t i = 0; i < n; i += W)
+        {
+            vf x = mul(to_float(load_u(phase + i)), turns); // [-1/2, 1/2)
+            x = min_f(x, sub(set_f(0.5f), x));
+            x = max_f(x, sub(set_f(-0.5f), x));
+            const vf t = mul(x, two_pi);
+            const vf t2 = mul(t, t);
+            vf p = set_f(-1.0f / 39916800.0f);
+            p = add(mul(p, t2), set_f(1.0f / 362880.0f));
+            p = add(mul(p, t2), set_f(-1.0f / 5040.0f));
+            p = add(mul(p, t2), set_f(1.0f / 120.0f));
+            p = add(mul(p, t2), set_f(-1.0f / 6.0f));
+            p = add(mul(p, t2), set_f(1.0f));
+            store_f(out + i, mul(mul(p, t), set_f(amp)));
+        }
+    }
+
+    // out += sigma * N(0, 1)4[1, 2)ȷֲ֮͵ķΪ1/3sqrt(3)õλ
+    // ضڡ3.46׼rҪ4n
+    void add_gaussian(const uint32_t* r, float* out, size_t n, float sigma)
+    {
+        const vf scale = set_f(sigma * 1.7320508f);
+        const vf six = set_f(6.0f);
+        for (size_t i = 0; i < n; i += W)
+        {
+            vf s = add(add(unit_interval(load_u(r + i)), unit_interval(load_u(r + n + i))),
+                add(unit_interval(load_u(r + 2 * n + i)), unit_interval(load_u(r + 3 * n + i))));
+            store_f(out + i, add(load_f(out + i), mul(sub(s, six), scale)));
+        }
+    }
+
+    uint64_t splitmix64(uint64_t& x)
+    {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+}
+
+signal_generator::signal_generator(const signal_params& params, double rate, uint64_t seed)
+    : amp_(float(params.amplitude)), state_(4 * LANES), scratch_(8 * BLOCK), fc32_(BLOCK)
+{
+    // ÿƽʣڰȼ
+    double power = params.amplitude * params.amplitude / 2;
+    const double two32 = 4294967296.0;
+    if (params.kind == "qpsk" || params.kind == "qam16" || params.kind == "qam64" || params.kind == "qam256")
+    {
+        kind_ = kind_t::qam;
+        bits_per_axis_ = (params.kind == "qpsk") ? 1 : (params.kind == "qam16") ? 2 : (params.kind == "qam64") ? 3 : 4;
+        const double levels = double(1u << bits_per_axis_);
+        power = params.amplitude * params.amplitude * (levels + 1) / (3 * (levels - 1));
+    }
+    else if (params.kind == "tone")
+    {
+        kind_ = kind_t::tone;
+        phase_step_ = uint32_t(int64_t(std::llround(params.freq / rate * two32)));
+    }
+    else if (params.kind == "chirp")
+    {
+        kind_ = kind_t::chirp;
+        const double bw = (params.chirp_bw > 0) ? params.chirp_bw : 0.8 * rate;
+        if (bw >= rate)
+            throw std::invalid_argument("Chirp bandwidth must be below the sample rate");
+        chirp_len_ = std::max<uint64_t>(1, uint64_t(std::llround(params.chirp_period * rate)));
+        chirp_start_ = chirp_step_ = -bw / 2 / rate * two32;
+        chirp_slope_ = bw / rate * two32 / double(chirp_len_);
+    }
+    else if (params.kind == "pn")
+    {
+        kind_ = kind_t::pn;
+        pn_ = make_pn_sequence(params.pn_order);
+    }
+    else if (params.kind == "noise")
+        kind_ = kind_t::noise;
+    else
+        throw std::invalid_argument("Unsupported signal: " + params.kind);
+
+    if (kind_ == kind_t::noise)
+        noise_sigma_ = amp_ / 4;
+    else if (std::isfinite(params.snr_db))
+        noise_sigma_ = float(std::sqrt(power / std::pow(10.0, params.snr_db / 10)));
+
+    for (auto& s : state_)
+        s = uint32_t(splitmix64(seed));
+    // xorshift128״̬ȫΪ0
+    for (size_t lane = 0; lane < LANES; lane++)
+    {
+        if ((state_[lane] | state_[LANES + lane] | state_[2 * LANES + lane] | state_[3 * LANES + lane]) == 0)
+            state_[3 * LANES + lane] = 1;
+    }
+}
+
+void signal_generator::fill_random(uint32_t* out, size_t n)
+{
+    // ÿ·xorshift128out[i*LANES + lane]Եlane·nΪLANESı
+    for (size_t g = 0; g < LANES; g += W)
+    {
+        vu x = load_u(&state_[g]);
+        vu y = load_u(&state_[LANES + g]);
+        vu z = load_u(&state_[2 * LANES + g]);
+        vu w = load_u(&state_[3 * LANES + g]);
+        for (size_t i = 0; i < n; i += LANES)
+        {
+            const vu t = xor_u(x, shl(x, 11));
+            x = y;
+            y = z;
+            z = w;
+            w = xor_u(xor_u(w, shr(w, 19)), xor_u(t, shr(t, 8)));
+            store_u(out + i + g, w);
+        }
+        store_u(&state_[g], x);
+        store_u(&state_[LANES + g], y);
+        store_u(&state_[2 * LANES + g], z);
+        store_u(&state_[3 * LANES + g], w);
+    }
+}
+
+void signal_generator::generate_block(float* out, size_t nsamps)
+{
+    // (I, Q)֯ÿnsampsΪBLOCK2*nsampsLANESı
+    const size_t n = nsamps * 2;
+    uint32_t* scratch = scratch_.data();
+    switch (kind_)
+    {
+    case kind_t::qam:
+        fill_random(scratch, n);
+        qam_levels(scratch, out, n, int(bits_per_axis_), amp_);
+        break;
+    case kind_t::tone:
+    case kind_t::chirp:
+        // λۼӱǴеģֻӷI·ǰ1/4ܣcosҲsinں
+        for (size_t i = 0; i < nsamps; i++)
+        {
+            scratch[2 * i] = phase_ + 0x40000000u;
+            scratch[2 * i + 1] = phase_;
+            if (kind_ == kind_t::tone)
+            {
+                phase_ += phase_step_;
+                continue;
+            }
+            phase_ += uint32_t(int64_t(chirp_step_));
+            chirp_step_ += chirp_slope_;
+            if (++chirp_pos_ == chirp_len_)
+            {
+                chirp_pos_ = 0;
+                chirp_step_ = chirp_start_;
+            }
+        }
+        sin_turns(scratch, out, n, amp_);
+        break;
+    case kind_t::pn:
+        for (size_t i = 0; i < nsamps; i++)
+        {
+            out[2 * i] = amp_ * pn_[pn_pos_];
+            out[2 * i + 1] = 0;
+            if (++pn_pos_ == pn_.size())
+                pn_pos_ = 0;
+        }
+        break;
+    case kind_t::noise:
+        std::fill(out, out + n, 0.0f);
+        break;
+    }
+
+    if (noise_sigma_ > 0)
+    {
+        fill_random(scratch, 4 * n);
+        add_gaussian(scratch, out, n, noise_sigma_);
+    }
+}
+
+void signal_generator::generate(std::complex<float>* out, size_t nsamps)
+{
+    generate(out, nsamps, "fc32");
+}
+
+void signal_generator::generate(void* out, size_t nsamps, const std::string& cpu_format)
+{
+    // ɵм仺壬תĿʽ߽粻Ӱźŵ
+    char* dst = static_cast<char*>(out);
+    const size_t bytes_per_samp = bytes_per_sample(cpu_format);
+    while (nsamps > 0)
+    {
+        if (avail_ == 0)
+        {
+            generate_block(reinterpret_cast<float*>(fc32_.data()), BLOCK);
+            avail_ = BLOCK;
+        }
+        const size_t n = std::min(nsamps, avail_);
+        const std::complex<float>* src = fc32_.data() + (BLOCK - avail_);
+        if (cpu_format == "sc16")
+            convert_fc32_to_sc16(src, reinterpret_cast<std::complex<int16_t>*>(dst), n);
+        else if (cpu_format == "sc8")
+            convert_fc32_to_sc8(src, reinterpret_cast<std::complex<int8_t>*>(dst), n);
+        else
+            std::memcpy(dst, src, n * sizeof(std::complex<float>));
+        avail_ -= n;
+        nsamps -= n;
+        dst += n * bytes_per_samp;
+    }
+}
+
+const char* signal_impl_name()
+{
+#if defined(SIGNAL_USE_AVX2)
+    return "avx2";
+#elif defined(SIGNAL_USE_SSE2)
+    return "sse2";
+#elif defined(SIGNAL_USE_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
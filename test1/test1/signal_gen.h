@@ -0,0 +1,65 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+// źŲ
+struct signal_params
+{
+    std::string kind = "qpsk";      // qpsk/qam16/qam64/qam256/tone/chirp/pn/noise
+    double amplitude = 1.0;         // ÿķֵΪ1noiseΪ4׼
+    double freq = 100e3;            // toneƵ(Hz)
+    double chirp_bw = 0;            // chirpɨƵ(Hz)0ʾ0.8
+    double chirp_period = 1e-3;     // chirpɨƵ()
+    int pn_order = 15;              // pnг2^order-1
+    double snr_db = std::numeric_limits<double>::infinity(); // Ӹ˹ȣinfʾ
+};
+
+// źŷ·еxorshift128λۼNCOӶʽң
+// ԼɾȷֲͽƵĸ˹ĿѡAVX2/SSE2/NEONʵ
+// һʵֻһ߳ʹ
+class signal_generator
+{
+public:
+    signal_generator(const signal_params& params, double rate, uint64_t seed);
+
+    // nsampsfc32
+    void generate(std::complex<float>* out, size_t nsamps);
+
+    // cpu_formatfc32/sc16/sc8ɣֵ
+    void generate(void* out, size_t nsamps, const std::string& cpu_format);
+
+private:
+    void generate_block(float* out, size_t nsamps);
+    void fill_random(uint32_t* out, size_t n);
+
+    enum class kind_t { qam, tone, chirp, pn, noise };
+
+    kind_t kind_;
+    float amp_;
+    unsigned bits_per_axis_ = 1;    // QAMÿı
+    float noise_sigma_ = 0;         // ÿ׼
+
+    uint32_t phase_ = 0;            // NCOλ2^32Ӧһ
+    uint32_t phase_step_ = 0;
+    double chirp_step_ = 0;         // chirpǰƵʣλ
+    double chirp_start_ = 0;
+    double chirp_slope_ = 0;        // ÿλ
+    uint64_t chirp_len_ = 0;
+    uint64_t chirp_pos_ = 0;
+
+    std::vector<float> pn_;
+    size_t pn_pos_ = 0;
+
+    std::vector<uint32_t> state_;   // xorshift128״̬xyzwLANES·
+    std::vector<uint32_t> scratch_; // λ
+    std::vector<std::complex<float>> fc32_; // ɵ
+    size_t avail_ = 0;              // fc32_ĩβδȡߵ
+};
+
+// ǰõźŷʵ
+const char* signal_impl_name();
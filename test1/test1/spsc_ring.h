@@ -0,0 +1,95 @@
+#pragma once
+
+#include "cache_line.h"
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// /߻ζ
+// вλڹʱһԷ䣬ڼ䲻ڴ
+template <typename T>
+class spsc_ring
+{
+public:
+    explicit spsc_ring(size_t capacity, const T& proto = T())
+        : slots_(round_up_pow2(capacity), proto), mask_(slots_.size() - 1)
+    {
+    }
+
+    spsc_ring(const spsc_ring&) = delete;
+    spsc_ring& operator=(const spsc_ring&) = delete;
+
+    // ߣȡһвλʱnullptr
+    T* acquire()
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_cache_ == slots_.size())
+        {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head - tail_cache_ == slots_.size())
+                return nullptr;
+        }
+        return &slots_[head & mask_];
+    }
+
+    // ߣacquire()ȡõĲλ
+    void publish()
+    {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // ߣȡöײλпʱnullptr
+    T* front()
+    {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_cache_)
+        {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail == head_cache_)
+                return nullptr;
+        }
+        return &slots_[tail & mask_];
+    }
+
+    // ߣ黹front()ȡõĲλ
+    void pop()
+    {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // ǰռòλ߳̿ɶͳã
+    size_t size() const
+    {
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        const size_t head = head_.load(std::memory_order_acquire);
+        return head - tail;
+    }
+
+    size_t capacity() const { return slots_.size(); }
+
+    // ʼλֻߺ֮ǰ
+    template <typename F>
+    void for_each_slot(F f)
+    {
+        for (T& slot : slots_)
+            f(slot);
+    }
+
+private:
+    static size_t round_up_pow2(size_t n)
+    {
+        size_t p = 1;
+        while (p < n)
+            p <<= 1;
+        return p;
+    }
+
+    std::vector<T> slots_;
+    const size_t mask_;
+
+    // ߸ԵڲͬУα
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> head_{ 0 };
+    size_t tail_cache_ = 0;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail_{ 0 };
+    size_t head_cache_ = 0;
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "dsp_stage.h"
+#include "metrics_exporter.h"
+#include "psd_monitor.h"
+#include "relay.h"
+#include "signal_gen.h"
+#include "thread_placement.h"
+#include "tx_flow.h"
+#include <uhd/types/device_addr.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class results_writer;
+
+// влļ
+struct test_config
+{
+    std::vector<std::string> devices;
+    std::string subdev;
+    std::vector<size_t> tx_chans;
+    std::vector<size_t> rx_chans;
+
+    double center_freq = 1e9;       // 1GHzƵ
+    double sample_rate = 1e6;       // 1MS/s
+    double master_clock_rate = 0;   // ʱӣ0ʾʹ豸Ĭֵ
+    double tx_gain = 15.0;          // 
+    double rx_gain = 20.0;          // 
+    size_t samps_per_buffer = 4096; // ÿ(spp)0ʾUHD
+    size_t tx_batch = 0;            // ÿsend()0ʾspp
+    size_t rx_batch = 0;            // ÿrecv()0ʾ4spp
+    double run_time = 10.0;         // ʱ()0ʾһֱеSIGINT/SIGTERM
+    size_t num_tx_buffers = 8;      // ͻ
+    size_t num_send_frames = 32;    // ֡
+    tx_flow_params tx_flow;         // Ӧأʱtx_batchÿ
+    size_t recv_buff_size = 16777216; // 16MBջ
+    std::string transport = "default"; // 
+    uhd::device_addr_t transport_args; // ó
+
+    std::string cpu_format;
+    size_t bytes_per_samp = 0;
+    bool zero_copy = false;
+    bool convert = false;
+    bool huge_pages = true;         // շʹôҳ
+
+    std::string clock_source = "internal"; // internalexternalgpsdo
+    std::string time_source = "internal";
+    std::string time_sync = "none"; // noneʼnow/pps豸ʱʱʼ
+    double start_delay = 0.5;       // ʱʼԵǰ豸ʱǰ()
+    bool reuse_device = true;       // 豸ʱ鸴Ѵ򿪵豸Ự
+    double retune_lead = 0.05;      // õĻỰصгʱʱԵǰ豸ʱǰ()0ʾг
+
+    std::string record_base;        // ǿʱѽ¼ΪSigMFļ
+    signal_params signal;           // ͵Ĳź
+    bool live_signal = false;       // ߳ʵʱźţѭԤɵĻ
+    uint64_t seed = 1;              // źŷӣͨiʹseed + i
+    std::string playback_path;      // ǿʱ͸ļе㣬ԤɵĻ
+    bool playback_loop = false;     // ļͷʼ
+    size_t prefetch_threads = 0;    // طԤ߳0ʾֻںԤ
+    size_t prefetch_ahead = size_t(64) << 20; // Ԥ(ֽ)
+
+    bool loopback = false;          // һͨ»صһͨ
+    int loopback_pn_order = 10;     // PNǳ2^order-1
+
+    size_t rx_restart_errors = 0;   // ٴκ0ʾ
+    double rx_restart_delay = 0.05; // ʱʱǰ()
+
+    double shutdown_timeout = 1.0;  // ֹͣʱȴͻACKſսյʱ()
+
+    dsp_params dsp;                 // պFIRȡ/ŵĬϲ
+    std::string dsp_record_base;    // ǿʱDSPĽ¼Ϊfc32 SigMFļ
+
+    psd_params psd;                 // Ƶ/ʼӣĬϲ
+    std::string psd_csv;            // ǿʱѸͨƽдCSVļ
+
+    exporter_params exporter;       // Prometheus/StatsDָ굼Ĭϲ
+
+    relay_params relay;             // ȫ˫м̣տ龭ʱأiͨӦiͨ
+
+    // ̵߳CPU󶨺ȼͺͽ߳Ĭʵʱȼ
+    thread_placement tx_thread{ {}, 1.0 };
+    thread_placement async_thread;
+    thread_placement rx_thread{ {}, 1.0 };
+    thread_placement consumer_thread;
+    thread_placement stats_thread;
+    thread_placement writer_thread;
+    thread_placement prefetch_thread;
+    thread_placement dsp_thread;
+    int numa_node = -1;             // NUMAڵ㣬-1ʾ
+
+    results_writer* results = nullptr; // ṹձʾ
+};
+
+// ʱշͬһ豸ʱ̿ʼ
+struct start_schedule
+{
+    bool timed = false;             // falseʱʼ
+    uhd::time_spec_t device_time;   // ʼʱ̣豸ʱ䣩
+    std::chrono::steady_clock::time_point host_time; // ʼʱ̶Ӧʱ䣨ֵ
+};
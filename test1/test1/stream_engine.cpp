@@ -0,0 +1,1367 @@
+#include "stream_engine.h"
+#include "buffer_arena.h"
+#include "convert.h"
+#include "device_setup.h"
+#include "dsp_stage.h"
+#include "event_flag.h"
+#include "loopback.h"
+#include "metrics.h"
+#include "metrics_exporter.h"
+#include "playback.h"
+#include "psd_monitor.h"
+#include "recorder.h"
+#include "relay_stream.h"
+#include "results.h"
+#include "signal_gen.h"
+#include "thread_placement.h"
+#include <uhd/usrp/multi_usrp.hpp>
+#include <uhd/version.hpp>
+#include <algorithm>
+#include <complex>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+    const size_t DEFAULT_BATCH = 4096;    // --sppΪ0δָСʱÿsend()
+
+    // ȫֹͣ־ռһУαȴ̺߳ͳ߳λʱ
+    alignas(CACHE_LINE_SIZE) event_flag stop_signal;
+
+    // request_stop()֮һֱΪtrue֮һʼͽ
+    std::atomic<bool> interrupted{ false };
+
+    // ¼ебʶʱ䣩ţɨʱͬһеĶ鹲run_id
+    const std::string run_id = utc_timestamp();
+    size_t trial_count = 0;
+
+    // رǣPNзʵtx_buffs[0]ͷд루ɿ㱣Ϊ0
+    template <typename T>
+    void fill_marker(const std::vector<char*>& buffs, size_t spp, const std::vector<float>& pn, T amp)
+    {
+        for (size_t i = 0; i < pn.size(); i++)
+            reinterpret_cast<std::complex<T>*>(buffs[i / spp])[i % spp] = std::complex<T>(T(pn[i] * amp), T(0));
+    }
+
+    template <typename T>
+    std::string join_list(const std::vector<T>& list, const char* sep = ",")
+    {
+        std::ostringstream ss;
+        for (size_t i = 0; i < list.size(); i++)
+            ss << (i == 0 ? "" : sep) << list[i];
+        return ss.str();
+    }
+
+    void add_placement(result_record& r, const std::string& name, const thread_placement& p)
+    {
+        r.add("cfg." + name + "_cpus", join_list(p.cpus));
+        r.add("cfg." + name + "_priority", p.priority);
+    }
+
+    // вѡӦ
+    void add_config(result_record& r, const test_config& cfg)
+    {
+        r.add("cfg.args", join_list(cfg.devices, ";"));
+        r.add("cfg.subdev", cfg.subdev);
+        r.add("cfg.tx_channels", join_list(cfg.tx_chans));
+        r.add("cfg.rx_channels", join_list(cfg.rx_chans));
+        r.add("cfg.freq", cfg.center_freq);
+        r.add("cfg.rate", cfg.sample_rate);
+        r.add("cfg.master_clock_rate", cfg.master_clock_rate);
+        r.add("cfg.tx_gain", cfg.tx_gain);
+        r.add("cfg.rx_gain", cfg.rx_gain);
+        r.add("cfg.spp", uint64_t(cfg.samps_per_buffer));
+        r.add("cfg.tx_batch", uint64_t(cfg.tx_batch));
+        r.add("cfg.rx_batch", uint64_t(cfg.rx_batch));
+        r.add("cfg.duration", cfg.run_time);
+        r.add("cfg.tx_buffers", uint64_t(cfg.num_tx_buffers));
+        r.add("cfg.num_send_frames", uint64_t(cfg.num_send_frames));
+        r.add("cfg.tx_latency", cfg.tx_flow.target_latency);
+        r.add("cfg.tx_max_latency", cfg.tx_flow.max_latency);
+        r.add("cfg.tx_flow_backoff", cfg.tx_flow.backoff);
+        r.add("cfg.tx_flow_probe", cfg.tx_flow.probe_interval);
+        r.add("cfg.relay_offset", cfg.relay.offset);
+        r.add("cfg.relay_process", cfg.relay.callback ? std::string("callback") : cfg.relay.process);
+        r.add("cfg.relay_gain", cfg.relay.gain);
+        r.add("cfg.recv_buff_size", uint64_t(cfg.recv_buff_size));
+        r.add("cfg.transport", cfg.transport);
+        r.add("cfg.transport_args", cfg.transport_args.to_string());
+        r.add("cfg.format", cfg.cpu_format);
+        r.add("cfg.zero_copy", cfg.zero_copy);
+        r.add("cfg.convert", cfg.convert);
+        r.add("cfg.huge_pages", cfg.huge_pages);
+        r.add("cfg.clock_source", cfg.clock_source);
+        r.add("cfg.time_source", cfg.time_source);
+        r.add("cfg.time_sync", cfg.time_sync);
+        r.add("cfg.start_delay", cfg.start_delay);
+        r.add("cfg.record", cfg.record_base);
+        r.add("cfg.signal", cfg.signal.kind);
+        r.add("cfg.signal_amp", cfg.signal.amplitude);
+        r.add("cfg.signal_freq", cfg.signal.freq);
+        r.add("cfg.chirp_bw", cfg.signal.chirp_bw);
+        r.add("cfg.chirp_period", cfg.signal.chirp_period);
+        r.add("cfg.signal_pn_order", cfg.signal.pn_order);
+        r.add("cfg.snr", cfg.signal.snr_db);
+        r.add("cfg.seed", cfg.seed);
+        r.add("cfg.live_signal", cfg.live_signal);
+        r.add("cfg.playback", cfg.playback_path);
+        r.add("cfg.playback_loop", cfg.playback_loop);
+        r.add("cfg.prefetch_threads", uint64_t(cfg.prefetch_threads));
+        r.add("cfg.prefetch_ahead", uint64_t(cfg.prefetch_ahead));
+        r.add("cfg.loopback", cfg.loopback);
+        r.add("cfg.loopback_pn_order", cfg.loopback_pn_order);
+        r.add("cfg.rx_restart_errors", uint64_t(cfg.rx_restart_errors));
+        r.add("cfg.rx_restart_delay", cfg.rx_restart_delay);
+        r.add("cfg.shutdown_timeout", cfg.shutdown_timeout);
+        r.add("cfg.reuse_device", cfg.reuse_device);
+        r.add("cfg.retune_lead", cfg.retune_lead);
+        r.add("cfg.dsp_decim", uint64_t(cfg.dsp.decim));
+        r.add("cfg.dsp_taps", uint64_t(cfg.dsp.taps));
+        r.add("cfg.dsp_channels", uint64_t(cfg.dsp.channels));
+        r.add("cfg.dsp_channel_taps", uint64_t(cfg.dsp.channel_taps));
+        r.add("cfg.dsp_threads", uint64_t(cfg.dsp.threads));
+        r.add("cfg.dsp_record", cfg.dsp_record_base);
+        r.add("cfg.psd_fft", uint64_t(cfg.psd.fft_size));
+        r.add("cfg.psd_avg", cfg.psd.alpha);
+        r.add("cfg.psd_frames", cfg.psd.frames_per_sec);
+        r.add("cfg.psd_interval", cfg.psd.publish_interval);
+        add_placement(r, "tx", cfg.tx_thread);
+        add_placement(r, "async", cfg.async_thread);
+        add_placement(r, "rx", cfg.rx_thread);
+        add_placement(r, "consumer", cfg.consumer_thread);
+        add_placement(r, "stats", cfg.stats_thread);
+        add_placement(r, "writer", cfg.writer_thread);
+        add_placement(r, "prefetch", cfg.prefetch_thread);
+        add_placement(r, "dsp", cfg.dsp_thread);
+        r.add("cfg.numa_node", cfg.numa_node);
+    }
+
+    // ÿͨȫΪtx<ͨ>.xxx / rx<ͨ>.xxx
+    void add_counters(result_record& r, const tx_channels_t& txs, const rx_channels_t& rxs)
+    {
+        for (const auto& tx : txs)
+        {
+            const std::string p = "tx" + std::to_string(tx->chan) + ".";
+            r.add(p + "samples", tx->metrics.samples.get());
+            r.add(p + "errors", tx->metrics.errors.get());
+            r.add(p + "calls", tx->metrics.calls.get());
+            r.add(p + "call_ns", tx->metrics.call_ns.get());
+            r.add(p + "cpu_ns", tx->metrics.cpu_ns.get());
+            if (tx->relay_buff != nullptr)  // мģʽ
+            {
+                r.add(p + "relay_blocks", tx->relay.blocks.get());
+                r.add(p + "relay_late", tx->relay.late.get());
+                r.add(p + "relay_skipped", tx->relay.skipped.get());
+                r.add(p + "relay_process_ns", tx->relay.process_ns.get());
+            }
+            if (tx->metrics.flow_depth.get() != 0)  // Ӧ
+            {
+                r.add(p + "flow_depth", tx->metrics.flow_depth.get());
+                r.add(p + "flow_batch", tx->metrics.flow_batch.get());
+                r.add(p + "flow_adjustments", tx->metrics.flow_adjustments.get());
+            }
+            r.add(p + "underflows", tx->async.underflows.get());
+            r.add(p + "seq_errors", tx->async.seq_errors.get());
+            r.add(p + "time_errors", tx->async.time_errors.get());
+            r.add(p + "burst_acks", tx->async.burst_acks.get());
+        }
+        for (const auto& rx : rxs)
+        {
+            const std::string p = "rx" + std::to_string(rx->chan) + ".";
+            r.add(p + "samples", rx->metrics.samples.get());
+            r.add(p + "overflows", rx->metrics.overflows.get());
+            r.add(p + "seq_errors", rx->metrics.seq_errors.get());
+            r.add(p + "timeouts", rx->metrics.timeouts.get());
+            r.add(p + "late_commands", rx->metrics.late_commands.get());
+            r.add(p + "other_errors", rx->metrics.other_errors.get());
+            r.add(p + "restarts", rx->metrics.restarts.get());
+            r.add(p + "drops", rx->metrics.drops.get());
+            r.add(p + "drained_samples", rx->metrics.drained_samples.get());
+            r.add(p + "calls", rx->metrics.calls.get());
+            r.add(p + "call_ns", rx->metrics.call_ns.get());
+            r.add(p + "cpu_ns", rx->metrics.cpu_ns.get());
+            r.add(p + "consumed_samples", rx->consumer.consumed_samples.get());
+            r.add(p + "converted_samples", rx->consumer.converted_samples.get());
+            r.add(p + "ring_used", uint64_t(rx->ring.size()));
+            r.add(p + "ring_high_water", rx->consumer.ring_high_water.get());
+            if (rx->rec != nullptr)
+            {
+                r.add(p + "recorded_bytes", rx->rec->bytes_written.get());
+                r.add(p + "writer_stalls", rx->rec->stalls.get());
+            }
+            if (rx->loopback != nullptr)
+            {
+                r.add(p + "loopback_markers", rx->loopback->markers.get());
+                r.add(p + "loopback_missed", rx->loopback->missed.get());
+                r.add(p + "loopback_slips", rx->loopback->slips.get());
+                r.add(p + "loopback_lost_samples", rx->loopback->lost_samples.get());
+            }
+            if (rx->dsp != nullptr)
+            {
+                const dsp_totals t = rx->dsp->totals();
+                r.add(p + "dsp_blocks", t.blocks);
+                r.add(p + "dsp_in_samples", t.in_samples);
+                r.add(p + "dsp_out_samples", t.out_samples);
+                r.add(p + "dsp_channel_frames", t.channel_frames);
+                r.add(p + "dsp_fir_ns", t.fir_ns);
+                r.add(p + "dsp_channel_ns", t.channel_ns);
+                r.add(p + "dsp_steals", t.steals);
+                r.add(p + "dsp_reordered", t.reordered);
+                r.add(p + "dsp_busy_ns", t.busy_ns);
+                r.add(p + "dsp_emitted_samples", rx->dsp->emitted_samples.get());
+                r.add(p + "dsp_stalls", rx->dsp->stalls.get());
+                r.add(p + "dsp_gaps", rx->dsp->gaps.get());
+            }
+            psd_snapshot s;
+            if (rx->psd != nullptr && rx->psd->snapshot(s) != 0)
+            {
+                r.add(p + "psd_frames", s.frames);
+                r.add(p + "psd_peak_bin", uint64_t(s.peak_bin));
+                r.add(p + "psd_peak_freq", s.peak_freq);
+                r.add(p + "psd_peak_db", double(s.peak_db));
+                r.add(p + "psd_floor_db", double(s.floor_db));
+                r.add(p + "psd_rms_dbfs", double(s.rms_dbfs));
+                r.add(p + "psd_max_dbfs", double(s.max_dbfs));
+                r.add(p + "psd_gaps", rx->psd->gaps.get());
+            }
+        }
+    }
+
+    // Ƶ׼ժҪƽ׵ķֵƵ͹ʡףһRMSͷֵ
+    void print_psd(const psd_monitor& psd)
+    {
+        psd_snapshot s;
+        if (psd.snapshot(s) == 0)
+        {
+            std::cout << " | PSD: -";
+            return;
+        }
+        std::cout << std::fixed << std::setprecision(1)
+            << " | PSD: " << s.peak_freq / 1e3 << " kHz " << s.peak_db << " dB, floor " << s.floor_db
+            << " | RMS " << s.rms_dbfs << " Pk " << s.max_dbfs << " dBFS";
+        std::cout.unsetf(std::ios::fixed);
+        std::cout << std::setprecision(6);
+    }
+
+    void add_latency(result_record& r, const std::string& name, const latency_histogram& hist)
+    {
+        r.add(name + ".count", hist.count());
+        r.add(name + ".p50_ns", hist.percentile(50.0));
+        r.add(name + ".p99_ns", hist.percentile(99.0));
+        r.add(name + ".p999_ns", hist.percentile(99.9));
+        r.add(name + ".max_ns", hist.max());
+    }
+
+    // CPUʱ߳
+    // ߳̿ڵѭĻطŷļ˳˳ʱдexit_cpu_ns0øֵ
+    // ߳CPUʱ䣬ȡʧʱlast_nsֵֻ
+    struct exported_thread
+    {
+        const char* kind;
+        size_t index;
+        std::thread* thread;
+        const counter* exit_cpu_ns;     // ߳˳ʱдCPUʱ䣬ûʱΪnullptr
+        uint64_t last_ns;               // ֻɵ̶߳д
+
+        uint64_t cpu_ns()
+        {
+            uint64_t ns = (exit_cpu_ns != nullptr) ? exit_cpu_ns->get() : 0;
+            if (ns == 0)
+                ns = uint64_t(std::max<int64_t>(0, thread_cpu_ns(*thread)));
+            last_ns = std::max(last_ns, ns);
+            return last_ns;
+        }
+    };
+
+    std::string chan_label(size_t chan)
+    {
+        return "chan=\"" + std::to_string(chan) + "\"";
+    }
+
+    // ̵߳Ĳɼͳ߳һֻȡֱͼͿ
+    void collect_metrics(metric_set& m, const tx_channels_t& txs, const rx_channels_t& rxs,
+        std::vector<exported_thread>& threads, std::chrono::steady_clock::time_point start_time)
+    {
+        m.gauge("trial", "trial number within this run", "", double(trial_count));
+        m.gauge("elapsed_seconds", "seconds since the streams started", "",
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count());
+        for (const auto& tx : txs)
+        {
+            const std::string l = chan_label(tx->chan);
+            m.counter("tx_samples_total", "samples sent", l, double(tx->metrics.samples));
+            m.counter("tx_errors_total", "send() calls that timed out before sending everything", l, double(tx->metrics.errors));
+            m.counter("tx_underflows_total", "TX underflow async messages", l, double(tx->async.underflows));
+            m.counter("tx_seq_errors_total", "TX sequence error async messages", l, double(tx->async.seq_errors));
+            m.counter("tx_time_errors_total", "TX late packet async messages", l, double(tx->async.time_errors));
+            m.counter("tx_burst_acks_total", "TX burst ACK async messages", l, double(tx->async.burst_acks));
+            m.summary("tx_send_latency_seconds", "duration of each send() call", l,
+                tx->metrics.send_latency, int64_t(tx->metrics.call_ns.get()));
+            if (tx->relay_buff != nullptr)
+            {
+                m.counter("relay_blocks_total", "RX blocks relayed to this TX channel", l, double(tx->relay.blocks));
+                m.counter("relay_late_total", "relayed blocks whose send() returned after their TX timestamp", l,
+                    double(tx->relay.late));
+                m.summary("relay_budget_used_seconds", "device time from a block's first RX sample until its send() returned", l,
+                    tx->relay.budget_used, -1);
+            }
+            if (tx->metrics.flow_depth.get() != 0)
+            {
+                m.gauge("tx_flow_depth_samples", "adaptive TX send-ahead depth", l, double(tx->metrics.flow_depth));
+                m.gauge("tx_flow_batch_samples", "adaptive TX samples per send() call", l, double(tx->metrics.flow_batch));
+                m.counter("tx_flow_adjustments_total", "adaptive TX depth changes", l, double(tx->metrics.flow_adjustments));
+                m.summary("tx_send_ahead_seconds", "estimated time from send() until the samples go out", l,
+                    tx->metrics.send_ahead, -1);
+            }
+        }
+        for (const auto& rx : rxs)
+        {
+            const std::string l = chan_label(rx->chan);
+            m.counter("rx_samples_total", "samples received", l, double(rx->metrics.samples));
+            m.counter("rx_overflows_total", "RX overflows (O)", l, double(rx->metrics.overflows));
+            m.counter("rx_seq_errors_total", "RX sequence errors (D), i.e. packets lost in transport", l, double(rx->metrics.seq_errors));
+            m.counter("rx_timeouts_total", "recv() timeouts", l, double(rx->metrics.timeouts));
+            m.counter("rx_late_commands_total", "RX late stream commands", l, double(rx->metrics.late_commands));
+            m.counter("rx_other_errors_total", "other recv() errors", l, double(rx->metrics.other_errors));
+            m.counter("rx_restarts_total", "RX stream restarts after errors", l, double(rx->metrics.restarts));
+            m.counter("rx_drops_total", "blocks dropped because the RX ring was full", l, double(rx->metrics.drops));
+            m.counter("rx_consumed_samples_total", "samples taken off the RX ring", l, double(rx->consumer.consumed_samples));
+            m.counter("rx_converted_samples_total", "samples converted to fc32", l, double(rx->consumer.converted_samples));
+            m.gauge("rx_ring_used", "RX ring slots in use", l, double(rx->ring.size()));
+            m.gauge("rx_ring_capacity", "RX ring slots", l, double(rx->ring.capacity()));
+            m.gauge("rx_ring_high_water", "most RX ring slots ever in use", l, double(rx->consumer.ring_high_water));
+            m.summary("rx_recv_latency_seconds", "duration of each recv() call, including the wait for data", l,
+                rx->metrics.recv_latency, int64_t(rx->metrics.call_ns.get()));
+            if (rx->rec != nullptr)
+            {
+                m.counter("rx_recorded_bytes_total", "bytes written by the recorder", l, double(rx->rec->bytes_written));
+                m.counter("rx_writer_stalls_total", "times the recorder had no free buffer", l, double(rx->rec->stalls));
+            }
+            if (rx->dsp != nullptr)
+            {
+                const dsp_totals t = rx->dsp->totals();
+                m.counter("dsp_in_samples_total", "samples processed by the DSP stage", l, double(t.in_samples));
+                m.counter("dsp_out_samples_total", "decimated samples", l, double(t.out_samples));
+                m.counter("dsp_busy_seconds_total", "DSP worker time spent on blocks", l, double(t.busy_ns) / 1e9);
+                m.counter("dsp_steals_total", "DSP blocks stolen by another worker", l, double(t.steals));
+                m.counter("dsp_reordered_total", "DSP blocks finished after a later block", l, double(t.reordered));
+                m.counter("dsp_stalls_total", "times the consumer waited for the oldest DSP block", l, double(rx->dsp->stalls));
+            }
+            psd_snapshot ps;
+            if (rx->psd != nullptr && rx->psd->snapshot(ps) != 0)
+            {
+                m.gauge("psd_rms_dbfs", "RMS power of the last PSD interval", l, double(ps.rms_dbfs));
+                m.gauge("psd_max_dbfs", "largest sample power of the last PSD interval", l, double(ps.max_dbfs));
+                m.gauge("psd_peak_db", "averaged spectrum peak", l, double(ps.peak_db));
+                m.gauge("psd_peak_freq_hz", "frequency offset of the averaged spectrum peak", l, ps.peak_freq);
+                m.gauge("psd_floor_db", "median of the averaged spectrum", l, double(ps.floor_db));
+            }
+            if (rx->loopback != nullptr)
+            {
+                m.counter("loopback_markers_total", "loopback markers found", l, double(rx->loopback->markers));
+                m.counter("loopback_missed_total", "loopback markers missed", l, double(rx->loopback->missed));
+                m.counter("loopback_slips_total", "loopback markers at an unexpected position", l, double(rx->loopback->slips));
+                m.summary("loopback_path_latency_seconds", "TX to RX delay over the loopback cable", l,
+                    rx->loopback->path_latency, -1);
+            }
+        }
+        for (exported_thread& t : threads)
+            m.counter("thread_cpu_seconds_total", "CPU time used by each streaming thread",
+                "thread=\"" + std::string(t.kind) + "\",index=\"" + std::to_string(t.index) + "\"",
+                double(t.cpu_ns()) / 1e9);
+    }
+}
+
+void request_stop()
+{
+    interrupted = true;
+    stop_signal.set();
+}
+
+bool stop_requested()
+{
+    return interrupted;
+}
+
+// ͳ̣߳ͨʱͨӡһУһΪϼ
+// ÿͬʱȫƽֵһͳڵ˲ʱֵָ--resultsʱÿдһinterval¼
+void stats_thread(const tx_channels_t& txs, const rx_channels_t& rxs, const test_config& cfg,
+    const result_record& meta)
+{
+    const bool per_channel = txs.size() > 1 || rxs.size() > 1;
+    auto to_mbps = [&](uint64_t samps, double duration)
+    {
+        return (samps * cfg.bytes_per_samp * 8) / (duration * 1e6);
+    };
+
+    std::vector<uint64_t> prev_tx(txs.size(), 0), prev_rx(rxs.size(), 0);
+    uint64_t prev_total_tx = 0, prev_total_rx = 0;
+
+    auto start_time = std::chrono::steady_clock::now();
+    auto prev_time = start_time;
+    while (!stop_signal.wait_for(std::chrono::seconds(1)))
+    {
+        const auto now = std::chrono::steady_clock::now();
+        auto duration = std::chrono::duration<double>(now - start_time).count();
+        const double interval = std::chrono::duration<double>(now - prev_time).count();
+        prev_time = now;
+
+        uint64_t total_tx_samples = 0, total_underflows = 0, total_seq_errors = 0;
+        uint64_t total_time_errors = 0, total_acks = 0, flow_depth = 0, relay_blocks = 0, relay_late = 0;
+        for (size_t i = 0; i < txs.size(); i++)
+        {
+            const auto& tx = txs[i];
+            const uint64_t samps = tx->metrics.samples;
+            const uint64_t delta = samps - prev_tx[i];
+            prev_tx[i] = samps;
+            total_tx_samples += samps;
+            total_underflows += tx->async.underflows;
+            total_seq_errors += tx->async.seq_errors;
+            total_time_errors += tx->async.time_errors;
+            total_acks += tx->async.burst_acks;
+            if (tx->metrics.flow_depth.get() != 0)
+                flow_depth = std::max<uint64_t>(flow_depth, tx->metrics.flow_depth);
+            relay_blocks += tx->relay.blocks;
+            relay_late += tx->relay.late;
+            if (per_channel)
+            {
+                std::cout << "  TX ch" << tx->chan << ": " << to_mbps(samps, duration) << " Mbps ("
+                    << to_mbps(delta, interval) << " now)"
+                    << " | U: " << tx->async.underflows << " S: " << tx->async.seq_errors
+                    << " L: " << tx->async.time_errors;
+                if (tx->relay_buff != nullptr)
+                    std::cout << " | Late: " << tx->relay.late << "/" << tx->relay.blocks;
+                if (tx->metrics.flow_depth.get() != 0)
+                    std::cout << " | Depth: " << tx->metrics.flow_depth * 1e3 / tx->rate << " ms (batch "
+                        << tx->metrics.flow_batch << ")";
+                std::cout << "\n";
+            }
+        }
+
+        uint64_t total_rx_samples = 0, total_converted = 0, total_drops = 0;
+        uint64_t total_overflows = 0, total_rx_seq_errors = 0, total_timeouts = 0;
+        uint64_t total_late = 0, total_restarts = 0;
+        size_t ring_used = 0, ring_size = 0;
+        uint64_t ring_high_water = 0, total_recorded = 0;
+        dsp_totals dsp;
+        uint64_t dsp_stalls = 0;
+        for (size_t i = 0; i < rxs.size(); i++)
+        {
+            const auto& rx = rxs[i];
+            const uint64_t samps = rx->metrics.samples;
+            const uint64_t delta = samps - prev_rx[i];
+            prev_rx[i] = samps;
+            total_rx_samples += samps;
+            total_converted += rx->consumer.converted_samples;
+            total_drops += rx->metrics.drops;
+            total_overflows += rx->metrics.overflows;
+            total_rx_seq_errors += rx->metrics.seq_errors;
+            total_timeouts += rx->metrics.timeouts;
+            total_late += rx->metrics.late_commands;
+            total_restarts += rx->metrics.restarts;
+            ring_used += rx->ring.size();
+            ring_size += rx->ring.capacity();
+            ring_high_water = std::max<uint64_t>(ring_high_water, rx->consumer.ring_high_water);
+            if (rx->rec != nullptr)
+                total_recorded += rx->rec->bytes_written;
+            if (rx->dsp != nullptr)
+            {
+                const dsp_totals t = rx->dsp->totals();
+                dsp.in_samples += t.in_samples;
+                dsp.out_samples += t.out_samples;
+                dsp.fir_ns += t.fir_ns;
+                dsp.channel_ns += t.channel_ns;
+                dsp.steals += t.steals;
+                dsp.reordered += t.reordered;
+                dsp.busy_ns += t.busy_ns;
+                dsp_stalls += rx->dsp->stalls;
+            }
+            if (per_channel)
+            {
+                std::cout << "  RX ch" << rx->chan << ": " << to_mbps(samps, duration) << " Mbps ("
+                    << to_mbps(delta, interval) << " now)"
+                    << " | Ring: " << rx->ring.size() << "/" << rx->ring.capacity()
+                    << " HW: " << rx->consumer.ring_high_water
+                    << " | Drops: " << rx->metrics.drops
+                    << " | O: " << rx->metrics.overflows << " D: " << rx->metrics.seq_errors
+                    << " T: " << rx->metrics.timeouts << " LC: " << rx->metrics.late_commands;
+                if (rx->psd != nullptr)
+                    print_psd(*rx->psd);
+                std::cout << "\n";
+            }
+        }
+        const loopback_analyzer* loopback = rxs.empty() ? nullptr : rxs.front()->loopback;
+
+        std::cout << "TX: " << to_mbps(total_tx_samples, duration) << " Mbps ("
+            << to_mbps(total_tx_samples - prev_total_tx, interval) << " now) | RX: "
+            << to_mbps(total_rx_samples, duration) << " Mbps ("
+            << to_mbps(total_rx_samples - prev_total_rx, interval) << " now)"
+            << " | Samples: " << total_rx_samples
+            << " | Ring: " << ring_used << "/" << ring_size << " HW: " << ring_high_water
+            << " | Drops: " << total_drops;
+        if (!cfg.record_base.empty())
+            std::cout << " | Rec: " << total_recorded / (duration * 1e6) << " MB/s";
+        if (cfg.convert)
+            std::cout << " | Conv: " << total_converted / (duration * 1e6) << " MS/s";
+        // DSPʣCPUʱĵ˴ʣ߳æµ
+        if (cfg.dsp.enabled() && !rxs.empty())
+        {
+            std::cout << " | DSP: " << dsp.in_samples / (duration * 1e6) << " MS/s";
+            if (dsp.fir_ns > 0)
+                std::cout << " (FIR " << dsp.in_samples * 1e3 / double(dsp.fir_ns) << " MS/s/core";
+            else
+                std::cout << " (";
+            if (dsp.channel_ns > 0)
+                std::cout << (dsp.fir_ns > 0 ? ", " : "") << "PFB " << dsp.out_samples * 1e3 / double(dsp.channel_ns)
+                    << " MS/s/core";
+            std::cout << ", busy " << 100.0 * double(dsp.busy_ns)
+                / (duration * 1e9 * double(cfg.dsp.threads * rxs.size())) << "%) ST: " << dsp_stalls
+                << " SW: " << dsp.steals << " RO: " << dsp.reordered;
+        }
+        if (!per_channel && !rxs.empty() && rxs.front()->psd != nullptr)
+            print_psd(*rxs.front()->psd);
+        if (loopback != nullptr)
+            std::cout << " | LB: " << loopback->markers << " M: " << loopback->missed
+                << " SL: " << loopback->slips;
+        if (!rxs.empty())
+            std::cout << " | O: " << total_overflows << " D: " << total_rx_seq_errors
+                << " T: " << total_timeouts << " LC: " << total_late << " R: " << total_restarts;
+        if (!txs.empty())
+            std::cout << " | U: " << total_underflows << " S: " << total_seq_errors
+                << " L: " << total_time_errors << " ACK: " << total_acks;
+        // Ӧأͨķǰ
+        if (flow_depth != 0)
+            std::cout << " | Depth: " << flow_depth * 1e3 / txs.front()->rate << " ms";
+        if (cfg.relay.enabled())
+            std::cout << " | Relay late: " << relay_late << "/" << relay_blocks;
+        std::cout << " | Time: " << int(duration) << "s\n";
+
+        if (cfg.results != nullptr)
+        {
+            result_record r;
+            r.add("time", utc_timestamp());
+            r.append(meta);
+            r.add("elapsed", duration);
+            r.add("tx.mbps", to_mbps(total_tx_samples, duration));
+            r.add("tx.mbps_now", to_mbps(total_tx_samples - prev_total_tx, interval));
+            r.add("rx.mbps", to_mbps(total_rx_samples, duration));
+            r.add("rx.mbps_now", to_mbps(total_rx_samples - prev_total_rx, interval));
+            add_counters(r, txs, rxs);
+            cfg.results->write("interval", r);
+        }
+
+        prev_total_tx = total_tx_samples;
+        prev_total_rx = total_rx_samples;
+    }
+}
+
+// ӡһеúʱֲλ΢
+void print_latency(const std::string& name, const latency_histogram& hist)
+{
+    std::cout << "  " << std::left << std::setw(10) << name << std::right
+        << std::setw(12) << hist.count()
+        << std::fixed << std::setprecision(1)
+        << std::setw(10) << hist.percentile(50.0) / 1e3
+        << std::setw(10) << hist.percentile(99.0) / 1e3
+        << std::setw(10) << hist.percentile(99.9) / 1e3
+        << std::setw(10) << hist.max() / 1e3 << "\n";
+    std::cout.unsetf(std::ios::fixed);
+    std::cout << std::setprecision(6);
+}
+
+// ӡһеÿÿôÿεÿκʱÿĵCPUʱ
+void print_calls(const std::string& name, uint64_t calls, uint64_t samples, uint64_t call_ns,
+    uint64_t cpu_ns, double elapsed)
+{
+    const double n = double(std::max<uint64_t>(calls, 1));
+    std::cout << "  " << std::left << std::setw(10) << name << std::right
+        << std::fixed << std::setprecision(1)
+        << std::setw(12) << calls / elapsed
+        << std::setw(12) << samples / n
+        << std::setw(10) << call_ns / n / 1e3
+        << std::setw(10) << cpu_ns / n / 1e3
+        << std::setw(10) << (samples > 0 ? double(cpu_ns) / double(samples) : 0.0) << "\n";
+    std::cout.unsetf(std::ios::fixed);
+    std::cout << std::setprecision(6);
+}
+
+trial_result run_trial(const test_config& cfg)
+{
+    const size_t spp = cfg.samps_per_buffer;
+
+    // 1. 򿪲USRP豸ʱϴĻỰֵһµò·
+    std::cout << "Transport: " << cfg.transport << " | Device args: " << make_device_addr(cfg).to_string() << std::endl;
+    setup_timings setup;
+    auto usrp = open_device(cfg, &setup);
+    configure_device(usrp, cfg, setup);
+    std::cout << "Startup: " << setup.total * 1e3 << " ms (device "
+        << (setup.reused ? std::string("reused") : std::to_string(setup.make * 1e3)) << ", subdev "
+        << setup.subdev * 1e3 << ", clock " << setup.clock * 1e3 << ", tune " << setup.tune * 1e3
+        << (setup.timed_retune ? " timed" : "") << ", time sync " << setup.time_sync * 1e3 << " ms) | "
+        << setup.applied << " settings applied, " << setup.skipped << " already set" << std::endl;
+    if (cfg.relay.enabled() && (cfg.rx_chans.empty() || cfg.rx_chans.size() != cfg.tx_chans.size()))
+        throw std::runtime_error("Relay mode needs as many TX channels as RX channels");
+    if (cfg.relay.enabled() && !cfg.relay.callback && cfg.relay.process != "copy" && cfg.relay.process != "gain")
+        throw std::runtime_error("Unknown relay process " + cfg.relay.process);
+
+    // 2. շһԴarena䣬ǰȱҳҳ
+    // ÿεõС޹أsend()ɶrecv()һȡض
+    const size_t batch_base = (spp != 0) ? spp : DEFAULT_BATCH;
+    // Ӧʱtx_batchֻޣĬϷſ8ذǰѡʵС
+    const size_t tx_batch = (cfg.tx_batch != 0) ? cfg.tx_batch : (cfg.tx_flow.enabled() ? 8 * batch_base : batch_base);
+    const size_t tx_buff_bytes = tx_batch * cfg.bytes_per_samp;
+    const size_t rx_block_samps = (cfg.rx_batch != 0) ? cfg.rx_batch : batch_base * 4;
+    const size_t rx_block_bytes = rx_block_samps * cfg.bytes_per_samp;
+    const size_t fc32_samps = (cfg.convert || cfg.loopback || cfg.dsp.enabled() || cfg.psd.fft_size > 0)
+        ? rx_block_samps : 0;
+    const size_t record_bytes = cfg.record_base.empty() ? 0 : recorder::arena_bytes();
+    const size_t dsp_bytes = cfg.dsp.enabled() ? dsp_stage::arena_bytes(cfg.dsp, rx_block_samps)
+        + (cfg.dsp_record_base.empty() ? 0 : recorder::arena_bytes()) : 0;
+    // طźмʱҪԤɵķͻ壻ʵʱʱÿͨһ壬мʱһտС
+    const size_t num_tx_buffs = (cfg.playback_path.empty() && !cfg.relay.enabled()) ? cfg.num_tx_buffers : 0;
+    const size_t num_live_buffs = cfg.live_signal ? cfg.tx_chans.size() : 0;
+    const size_t relay_bytes = cfg.relay.enabled() ? cfg.tx_chans.size() * buffer_arena::footprint(rx_block_bytes) : 0;
+    buffer_arena arena((num_tx_buffs + num_live_buffs) * buffer_arena::footprint(tx_buff_bytes) + relay_bytes
+        + cfg.rx_chans.size() * (rx_channel::arena_bytes(rx_block_bytes, fc32_samps) + record_bytes + dsp_bytes),
+        cfg.huge_pages);
+    std::cout << "Buffer arena: " << arena.size() / 1e6 << " MB, " << arena.page_kind()
+        << (arena.locked() ? ", locked" : ", not locked (check RLIMIT_MEMLOCK)") << std::endl;
+
+    // ɲźţԤɶзͨãɣ֮ź
+    // ģʽлһ֡֡ΪPNǣΪ0arena㣩
+    const size_t frame_len = cfg.num_tx_buffers * tx_batch;
+    const std::vector<float> pn = cfg.loopback ? make_pn_sequence(cfg.loopback_pn_order) : std::vector<float>();
+    if (pn.size() >= frame_len)
+        throw std::runtime_error("PN marker does not fit in tx-batch * tx-buffers samples");
+    std::vector<char*> tx_buffs(num_tx_buffs);
+    signal_generator gen(cfg.signal, cfg.sample_rate, cfg.seed);
+    for (auto& buff : tx_buffs)
+    {
+        buff = static_cast<char*>(arena.allocate(tx_buff_bytes));
+        if (!cfg.loopback)
+            gen.generate(buff, tx_batch, cfg.cpu_format);
+    }
+    if (cfg.loopback)
+    {
+        if (cfg.cpu_format == "sc16")
+            fill_marker(tx_buffs, tx_batch, pn, int16_t(23000));
+        else if (cfg.cpu_format == "sc8")
+            fill_marker(tx_buffs, tx_batch, pn, int8_t(90));
+        else
+            fill_marker(tx_buffs, tx_batch, pn, 0.7f);
+    }
+
+    // 3. ÿͨһsc8sc8ϸʽsc16
+    // RFNoC豸Ĵȡ豸һ
+    const std::string otw_format = (cfg.cpu_format == "sc8") ? "sc8" : "sc16";
+    tx_channels_t txs;
+    for (size_t chan : cfg.tx_chans)
+    {
+        uhd::stream_args_t tx_args(cfg.cpu_format, otw_format);
+        tx_args.channels = { chan };
+        if (spp != 0)
+            tx_args.args["spp"] = std::to_string(spp);
+        tx_args.args["num_send_frames"] = std::to_string(cfg.num_send_frames); // ӷ֡
+        txs.emplace_back(new tx_channel(chan, usrp->get_tx_stream(tx_args)));
+        txs.back()->batch = tx_batch;
+        txs.back()->rate = usrp->get_tx_rate(chan);
+        if (cfg.relay.enabled())
+            txs.back()->relay_buff = static_cast<char*>(arena.allocate(rx_block_bytes));
+    }
+
+    // ʵʱɣÿͨһӲͬȲһٶǷϲ
+    if (cfg.live_signal && !txs.empty())
+    {
+        for (size_t i = 0; i < txs.size(); i++)
+        {
+            txs[i]->gen.reset(new signal_generator(cfg.signal, usrp->get_tx_rate(txs[i]->chan), cfg.seed + i));
+            txs[i]->live_buff = static_cast<char*>(arena.allocate(tx_buff_bytes));
+        }
+        signal_generator probe(cfg.signal, cfg.sample_rate, cfg.seed);
+        size_t generated = 0;
+        const auto t0 = std::chrono::steady_clock::now();
+        double seconds = 0;
+        while (seconds < 0.05)
+        {
+            probe.generate(txs.front()->live_buff, tx_batch, cfg.cpu_format);
+            generated += tx_batch;
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        }
+        const double gen_rate = generated / seconds;
+        std::cout << "Live " << cfg.signal.kind << " generation: " << gen_rate / 1e6 << " MS/s per TX thread ("
+            << signal_impl_name() << ")" << std::endl;
+        if (gen_rate < 2 * usrp->get_tx_rate(cfg.tx_chans.front()))
+            std::cerr << "Warning: generation leaves little headroom over the TX rate; underflows are likely" << std::endl;
+    }
+
+    // طţзͨͬһļԤһͨĽ
+    std::unique_ptr<playback_file> playback;
+    if (!cfg.playback_path.empty() && !txs.empty())
+    {
+        playback.reset(new playback_file(cfg.playback_path, cfg.cpu_format, cfg.playback_loop));
+        for (auto& tx : txs)
+            tx->playback = playback.get();
+        std::cout << "Playing back " << playback->data_path() << ": " << playback->num_samps() << " samples"
+            << (playback->loop() ? ", looped" : "") << std::endl;
+        const double file_rate = playback->sample_rate();
+        if (file_rate > 0 && std::abs(file_rate - usrp->get_tx_rate(cfg.tx_chans.front())) > 1.0)
+            std::cerr << "Warning: " << cfg.playback_path << " was recorded at " << file_rate / 1e6
+                << " MS/s, playing back at " << usrp->get_tx_rate(cfg.tx_chans.front()) / 1e6 << " MS/s" << std::endl;
+        if (cfg.prefetch_threads > 0)
+            playback->start_prefetch(txs.front()->metrics.samples, cfg.prefetch_threads, cfg.prefetch_ahead,
+                cfg.prefetch_thread);
+    }
+
+    // ջζУֻ߳λ̸߳ȡ
+    const size_t rx_chans_per_mboard = std::max<size_t>(1, usrp->get_rx_subdev_spec(0).size());
+    rx_channels_t rxs;
+    for (size_t chan : cfg.rx_chans)
+    {
+        uhd::stream_args_t rx_args(cfg.cpu_format, otw_format);
+        rx_args.channels = { chan };
+        rx_args.args["recv_buff_size"] = std::to_string(cfg.recv_buff_size);
+        rxs.emplace_back(new rx_channel(chan, chan / rx_chans_per_mboard, usrp->get_rx_stream(rx_args),
+            arena, rx_block_bytes, fc32_samps));
+        rxs.back()->rate = usrp->get_rx_rate(chan);
+        rxs.back()->batch = rx_block_samps;
+    }
+
+    // ÿεöӦİ˵ÿ̯
+    if (!txs.empty() && !cfg.relay.enabled())
+        std::cout << "send() batch: " << tx_batch << " samples, packet " << txs.front()->stream->get_max_num_samps()
+            << " samples (" << (tx_batch + txs.front()->stream->get_max_num_samps() - 1) / txs.front()->stream->get_max_num_samps()
+            << " packets per call)" << std::endl;
+    if (cfg.relay.enabled())
+    {
+        const double block_time = rx_block_samps / rxs.front()->rate;
+        std::cout << "Relay: " << (cfg.relay.callback ? "callback" : cfg.relay.process) << ", TX time = RX time + "
+            << cfg.relay.offset * 1e3 << " ms, block " << block_time * 1e3 << " ms" << std::endl;
+        if (cfg.relay.offset <= block_time)
+            std::cerr << "Warning: --relay-offset is not longer than one RX block; every block will be late" << std::endl;
+    }
+    if (!txs.empty() && cfg.tx_flow.enabled())
+        std::cout << "TX flow control: target " << cfg.tx_flow.target_latency * 1e3 << " ms, max "
+            << cfg.tx_flow.max_latency * 1e3 << " ms, backoff x" << cfg.tx_flow.backoff
+            << ", batch up to " << tx_batch << " samples" << std::endl;
+    if (!rxs.empty())
+        std::cout << "recv() batch: " << rx_block_samps << " samples, packet " << rxs.front()->stream->get_max_num_samps()
+            << " samples (" << (rx_block_samps + rxs.front()->stream->get_max_num_samps() - 1) / rxs.front()->stream->get_max_num_samps()
+            << " packets per call)" << std::endl;
+
+    // ¼ƣÿͨһSigMFļͨʱļͨ
+    std::vector<std::unique_ptr<recorder>> recorders;
+    if (!cfg.record_base.empty())
+    {
+        for (auto& rx : rxs)
+        {
+            sigmf_info info;
+            info.cpu_format = cfg.cpu_format;
+            info.sample_rate = rx->rate;
+            info.center_freq = usrp->get_rx_freq(rx->chan);
+            info.hw = usrp->get_mboard_name(rx->mboard);
+            const std::string base = (rxs.size() > 1)
+                ? cfg.record_base + "_ch" + std::to_string(rx->chan) : cfg.record_base;
+            recorders.emplace_back(new recorder(base, info, arena, cfg.writer_thread));
+            rx->rec = recorders.back().get();
+            std::cout << "Recording RX ch" << rx->chan << " to " << rx->rec->data_path()
+                << (rx->rec->direct_io() ? " (O_DIRECT)" : " (buffered)") << std::endl;
+        }
+    }
+
+    // DSPÿͨһ̳߳أͨ߳--dsp-cpus
+    // Ľ¼Ϊfc32 SigMFļŵʱÿ֡channels㰴ŵ
+    std::vector<std::unique_ptr<dsp_stage>> dsps;
+    std::vector<std::unique_ptr<recorder>> dsp_recorders;
+    if (cfg.dsp.enabled())
+    {
+        for (size_t i = 0; i < rxs.size(); i++)
+        {
+            thread_placement placement = cfg.dsp_thread;
+            if (!placement.cpus.empty())
+            {
+                placement.cpus.clear();
+                for (size_t k = 0; k < cfg.dsp.threads; k++)
+                    placement.cpus.push_back(cfg.dsp_thread.for_thread(i * cfg.dsp.threads + k).cpus.front());
+            }
+            dsps.emplace_back(new dsp_stage(cfg.dsp, rx_block_samps, arena, placement));
+            rxs[i]->dsp = dsps.back().get();
+            if (!cfg.dsp_record_base.empty())
+            {
+                sigmf_info info;
+                info.cpu_format = "fc32";
+                info.sample_rate = rxs[i]->rate / double(cfg.dsp.decim);
+                info.center_freq = usrp->get_rx_freq(rxs[i]->chan);
+                info.hw = usrp->get_mboard_name(rxs[i]->mboard);
+                if (cfg.dsp.channels > 1)
+                    info.hw += ", " + std::to_string(cfg.dsp.channels) + "-channel PFB frames";
+                const std::string base = (rxs.size() > 1)
+                    ? cfg.dsp_record_base + "_ch" + std::to_string(rxs[i]->chan) : cfg.dsp_record_base;
+                dsp_recorders.emplace_back(new recorder(base, info, arena, cfg.writer_thread));
+                recorder* rec = dsp_recorders.back().get();
+                dsps.back()->set_output([rec](const std::complex<float>* data, size_t nsamps, int64_t index)
+                    { rec->write(data, nsamps, index); });
+                std::cout << "Recording DSP output of RX ch" << rxs[i]->chan << " to " << rec->data_path() << std::endl;
+            }
+        }
+        const dsp_stage& d = *dsps.front();
+        std::cout << "DSP stage: " << cfg.dsp.threads << " threads per RX channel";
+        if (d.fir() != nullptr)
+            std::cout << " | FIR decimate by " << d.fir()->decim() << ", " << d.fir()->num_taps() << " taps";
+        if (d.channelizer() != nullptr)
+            std::cout << " | PFB " << d.channelizer()->channels() << " channels, " << d.channelizer()->num_taps() << " taps";
+        std::cout << " (" << fir_impl_name() << ")" << std::endl;
+    }
+
+    // Ƶ׼ӣÿͨһ̴߳
+    std::vector<std::unique_ptr<psd_monitor>> psds;
+    if (cfg.psd.fft_size > 0)
+    {
+        for (auto& rx : rxs)
+        {
+            psds.emplace_back(new psd_monitor(cfg.psd, rx->rate));
+            rx->psd = psds.back().get();
+        }
+    }
+
+    // أһͨ¼ÿ֡ʱ䣬һͨ߳
+    frame_clock frames;
+    std::unique_ptr<loopback_analyzer> loopback;
+    if (cfg.loopback && !txs.empty() && !rxs.empty())
+    {
+        loopback.reset(new loopback_analyzer(pn, frame_len, usrp->get_rx_rate(cfg.rx_chans.front()), &frames));
+        txs.front()->frames = &frames;
+        rxs.front()->loopback = loopback.get();
+    }
+
+    // ʱʼʱȡǰ豸ʱǰ̨豸PPSʱ䣬˻ͬһ㿪ʼ
+    start_schedule start;
+    if (cfg.time_sync != "none")
+    {
+        start.timed = true;
+        start.device_time = usrp->get_time_now() + uhd::time_spec_t(cfg.start_delay);
+        start.host_time = std::chrono::steady_clock::now()
+            + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(cfg.start_delay));
+        std::cout << "Streams start at device time " << start.device_time.get_real_secs() << " s" << std::endl;
+    }
+
+    // Ԫݣÿ¼ϣڿ汾Ƚ
+    ++trial_count;
+    result_record meta;
+    if (cfg.results != nullptr)
+    {
+        meta.add("run_id", run_id);
+        meta.add("trial", uint64_t(trial_count));
+        meta.add("uhd.version", uhd::get_version_string());
+        add_host_info(meta);
+        for (size_t m = 0; m < usrp->get_num_mboards(); m++)
+            meta.add("device" + std::to_string(m) + ".name", usrp->get_mboard_name(m));
+        for (const auto& tx : txs)
+        {
+            const auto info = usrp->get_usrp_tx_info(tx->chan);
+            meta.add("tx" + std::to_string(tx->chan) + ".serial", info.get("mboard_serial", ""));
+            meta.add("tx" + std::to_string(tx->chan) + ".rate", usrp->get_tx_rate(tx->chan));
+        }
+        for (const auto& rx : rxs)
+        {
+            const auto info = usrp->get_usrp_rx_info(rx->chan);
+            meta.add("rx" + std::to_string(rx->chan) + ".serial", info.get("mboard_serial", ""));
+            meta.add("rx" + std::to_string(rx->chan) + ".rate", rx->rate);
+        }
+        meta.add("master_clock_rate", usrp->get_master_clock_rate());
+        meta.add("tx_batch", uint64_t(txs.empty() ? 0 : tx_batch));
+        meta.add("rx_batch", uint64_t(rxs.empty() ? 0 : rx_block_samps));
+        meta.add("startup.total_s", setup.total);
+        meta.add("startup.make_s", setup.make);
+        meta.add("startup.subdev_s", setup.subdev);
+        meta.add("startup.clock_s", setup.clock);
+        meta.add("startup.tune_s", setup.tune);
+        meta.add("startup.time_sync_s", setup.time_sync);
+        meta.add("startup.applied", uint64_t(setup.applied));
+        meta.add("startup.skipped", uint64_t(setup.skipped));
+        meta.add("startup.reused", setup.reused);
+        add_config(meta, cfg);
+    }
+
+    // ָ굼Ķ˿κ֮߳ǰ򿪣򲻿ʱֱʧ
+    std::unique_ptr<metrics_exporter> exporter;
+    if (cfg.exporter.enabled())
+    {
+        exporter.reset(new metrics_exporter(cfg.exporter));
+        if (cfg.exporter.http_port > 0)
+            std::cout << "Serving Prometheus metrics on http://" << cfg.exporter.http_bind << ":"
+                << cfg.exporter.http_port << "/metrics" << std::endl;
+        if (!cfg.exporter.statsd.empty())
+            std::cout << "Pushing StatsD metrics to " << cfg.exporter.statsd << " every "
+                << cfg.exporter.statsd_interval << " s" << std::endl;
+    }
+
+    // 4. ͳ̣߳Ѿֹͣʱһʼͽ
+    stop_signal.reset();
+    if (interrupted)
+        stop_signal.set();
+    std::thread stats = start_thread(cfg.stats_thread, stats_thread, std::cref(txs), std::cref(rxs), std::cref(cfg),
+        std::cref(meta));
+
+    // 5. ÿͨһ̺߳һ첽Ϣ߳
+    std::atomic<bool> tx_done{ false };
+    std::atomic<bool> async_done{ false };
+    std::vector<std::thread> tx_threads, async_threads;
+    for (size_t i = 0; i < txs.size(); i++)
+    {
+        async_threads.push_back(start_thread(cfg.async_thread.for_thread(i),
+            tx_async_worker, std::ref(*txs[i]), std::cref(async_done)));
+        if (!cfg.relay.enabled())
+            tx_threads.push_back(start_thread(cfg.tx_thread.for_thread(i),
+                tx_worker, std::ref(*txs[i]), std::cref(cfg), std::cref(tx_buffs), std::cref(start), std::cref(tx_done)));
+    }
+
+    // 6. ÿͨһ̺߳һ̣߳мʱiͨ͵iͨһм߳ӣ
+    // ߵ̺߳ͷ̣߳ʹ÷̵߳ĵ
+    std::atomic<bool> consumer_done{ false };
+    std::atomic<bool> rx_done{ false };
+    std::vector<std::thread> consumer_threads, rx_threads, relay_threads;
+    for (size_t i = 0; i < rxs.size(); i++)
+    {
+        if (!cfg.relay.enabled())
+            consumer_threads.push_back(start_thread(cfg.consumer_thread.for_thread(i),
+                consumer_worker, std::ref(*rxs[i]), std::cref(cfg), std::cref(start), std::cref(consumer_done)));
+        else if (cfg.relay.callback)
+            relay_threads.push_back(start_thread(cfg.tx_thread.for_thread(i), relay_worker<relay_fn>,
+                std::ref(*rxs[i]), std::ref(*txs[i]), std::cref(cfg), std::cref(consumer_done), cfg.relay.callback));
+        else if (cfg.relay.process == "gain")
+            relay_threads.push_back(start_thread(cfg.tx_thread.for_thread(i), relay_worker<relay_gain>,
+                std::ref(*rxs[i]), std::ref(*txs[i]), std::cref(cfg), std::cref(consumer_done),
+                relay_gain(float(cfg.relay.gain), cfg.cpu_format)));
+        else
+            relay_threads.push_back(start_thread(cfg.tx_thread.for_thread(i), relay_worker<relay_copy>,
+                std::ref(*rxs[i]), std::ref(*txs[i]), std::cref(cfg), std::cref(consumer_done),
+                relay_copy(cfg.bytes_per_samp)));
+        rx_threads.push_back(start_thread(cfg.rx_thread.for_thread(i),
+            rx_worker, usrp, std::ref(*rxs[i]), std::cref(cfg), std::cref(start), std::cref(rx_done)));
+    }
+
+    // 7. ָʱ䣬run_timeΪ0ʱһֱУʱʱӿʼʱrequest_stop()ʱǰ
+    if (start.timed)
+        stop_signal.wait_until(start.host_time);
+    const auto start_time = std::chrono::steady_clock::now();
+
+    // ָ굼̶߳߳бٱ仯ֹͣ豸ǰ
+    // ͺмܸ߳̿˳ʱдcpu_nsѽ̵߳Ķȡ
+    std::vector<exported_thread> exported_threads;
+    if (exporter)
+    {
+        for (auto* list : { &tx_threads, &async_threads, &rx_threads, &consumer_threads, &relay_threads })
+        {
+            const char* kind = (list == &tx_threads) ? "tx" : (list == &async_threads) ? "async"
+                : (list == &rx_threads) ? "rx" : (list == &consumer_threads) ? "consumer" : "relay";
+            for (size_t i = 0; i < list->size(); i++)
+            {
+                const counter* exit_cpu_ns = (list == &tx_threads || list == &relay_threads) ? &txs[i]->metrics.cpu_ns
+                    : (list == &rx_threads) ? &rxs[i]->metrics.cpu_ns : nullptr;
+                exported_threads.push_back({ kind, i, &(*list)[i], exit_cpu_ns, 0 });
+            }
+        }
+        exporter->start([&](metric_set& m) { collect_metrics(m, txs, rxs, exported_threads, start_time); },
+            cfg.stats_thread);
+    }
+
+    const auto deadline = start_time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(cfg.run_time));
+    if (cfg.run_time > 0)
+        stop_signal.wait_until(deadline);
+    else
+        stop_signal.wait();
+    if (interrupted)
+        std::cout << "\nStop requested, shutting down" << std::endl;
+    if (exporter)
+        exporter->stop();
+
+    // 8. ̷ֹͣ߳굱ǰһEOB߳ͣ;İſյУͬʱ
+    // ÿһȴԷ̵֪߳ͨ˳ʱֻȡ豸ѯ
+    const auto stop_time = std::chrono::steady_clock::now();
+    tx_done = true;
+    rx_done = true;
+    for (auto& t : tx_threads)
+        t.join();
+    for (auto& t : rx_threads)
+        t.join();
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+    // ߳ȡʣĿ飬¼ƺDSPŽм̷߳ʣĿEOB
+    consumer_done = true;
+    for (auto& t : consumer_threads)
+        t.join();
+    for (auto& t : relay_threads)
+        t.join();
+    for (auto& rec : recorders)
+        rec->finish();
+    for (auto& dsp : dsps)
+        dsp->finish();
+    for (auto& rec : dsp_recorders)
+        rec->finish();
+
+    // ȴÿͨͻACK豸껺еظ֮Ƿؼ׼ȷ
+    const auto ack_deadline = stop_time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(cfg.shutdown_timeout));
+    size_t eob_acks = 0;
+    for (auto& tx : txs)
+    {
+        if (tx->burst_acked.wait_until(ack_deadline))
+            eob_acks++;
+    }
+    async_done = true;
+    for (auto& t : async_threads)
+        t.join();
+    stop_signal.set();
+    stats.join();
+    const double shutdown = std::chrono::duration<double>(std::chrono::steady_clock::now() - stop_time).count();
+
+    trial_result result;
+    uint64_t total_consumed = 0, total_converted = 0;
+    for (const auto& tx : txs)
+    {
+        result.tx_samples += tx->metrics.samples;
+        result.tx_errors += tx->metrics.errors;
+        result.tx_underflows += tx->async.underflows;
+        result.tx_seq_errors += tx->async.seq_errors;
+        result.tx_time_errors += tx->async.time_errors;
+        result.tx_calls += tx->metrics.calls;
+        result.tx_call_ns += tx->metrics.call_ns;
+        result.tx_cpu_ns += tx->metrics.cpu_ns;
+    }
+    for (const auto& rx : rxs)
+    {
+        result.rx_samples += rx->metrics.samples;
+        result.rx_errors += rx->metrics.errors();
+        result.rx_overflows += rx->metrics.overflows;
+        result.rx_seq_errors += rx->metrics.seq_errors;
+        result.rx_restarts += rx->metrics.restarts;
+        result.drops += rx->metrics.drops;
+        result.rx_drained += rx->metrics.drained_samples;
+        result.rx_calls += rx->metrics.calls;
+        result.rx_call_ns += rx->metrics.call_ns;
+        result.rx_cpu_ns += rx->metrics.cpu_ns;
+        total_consumed += rx->consumer.consumed_samples;
+        total_converted += rx->consumer.converted_samples;
+    }
+    result.tx_mbps = (result.tx_samples * cfg.bytes_per_samp * 8) / (elapsed * 1e6);
+    result.rx_mbps = (result.rx_samples * cfg.bytes_per_samp * 8) / (elapsed * 1e6);
+    result.tx_batch = txs.empty() ? 0 : tx_batch;
+    result.startup = setup.total;
+    result.rx_batch = rxs.empty() ? 0 : rx_block_samps;
+    result.elapsed = elapsed;
+    result.tx_eob_acks = eob_acks;
+    result.shutdown = shutdown;
+
+    uint64_t ring_high_water = 0;
+    size_t ring_capacity = 0;
+    for (const auto& rx : rxs)
+    {
+        ring_high_water = std::max<uint64_t>(ring_high_water, rx->consumer.ring_high_water);
+        ring_capacity = rx->ring.capacity();
+    }
+    std::cout << "\nTest completed. Final RX samples: " << result.rx_samples
+        << " | Consumed: " << total_consumed
+        << " | Ring drops: " << result.drops
+        << " | Ring high-water: " << ring_high_water << "/" << ring_capacity << std::endl;
+    std::cout << "Shutdown: " << shutdown * 1e3 << " ms";
+    if (!txs.empty())
+        std::cout << " | TX EOB ACK: " << eob_acks << "/" << txs.size();
+    if (!rxs.empty())
+        std::cout << " | RX drained: " << result.rx_drained << " samples";
+    std::cout << std::endl;
+    if (eob_acks < txs.size())
+        std::cerr << "Warning: no burst ACK within --shutdown-timeout; TX counters may miss the last underflows" << std::endl;
+    // м̣ÿڷʱ֮ǰʣ豸ϱʱٵİ
+    for (size_t i = 0; i < txs.size() && cfg.relay.enabled(); i++)
+    {
+        const tx_channel& tx = *txs[i];
+        const latency_histogram& used = tx.relay.budget_used;
+        const double offset_ms = cfg.relay.offset * 1e3;
+        std::cout << "Relay RX ch" << rxs[i]->chan << " -> TX ch" << tx.chan << ": " << tx.relay.blocks << " blocks, late "
+            << tx.relay.late << " (device time errors " << tx.async.time_errors << "), skipped " << tx.relay.skipped
+            << " | slack p50 " << offset_ms - used.percentile(50.0) / 1e6 << " p1 " << offset_ms - used.percentile(99.0) / 1e6
+            << " min " << offset_ms - used.max() / 1e6 << " ms";
+        if (tx.relay.blocks > 0)
+            std::cout << " | process " << tx.relay.process_ns / 1e3 / double(tx.relay.blocks) << " us/block";
+        std::cout << std::endl;
+        result.relay_late += tx.relay.late;
+        const double slack = cfg.relay.offset - used.max() * 1e-9;
+        result.relay_slack = (i == 0) ? slack : std::min(result.relay_slack, slack);
+    }
+    // Ӧѡǰʵʲõķӳ
+    for (const auto& tx : txs)
+    {
+        if (tx->metrics.flow_depth.get() == 0)
+            continue;
+        const latency_histogram& ahead = tx->metrics.send_ahead;
+        std::cout << "TX flow ch" << tx->chan << ": depth " << tx->metrics.flow_depth << " samples ("
+            << tx->metrics.flow_depth * 1e3 / tx->rate << " ms), batch " << tx->metrics.flow_batch
+            << ", adjustments " << tx->metrics.flow_adjustments << ", underflows " << tx->async.underflows
+            << " | TX latency p50 " << ahead.percentile(50.0) / 1e6 << " p99 " << ahead.percentile(99.0) / 1e6
+            << " max " << ahead.max() / 1e6 << " ms" << std::endl;
+        result.tx_flow_depth = std::max<uint64_t>(result.tx_flow_depth, tx->metrics.flow_depth);
+        result.tx_latency = std::max(result.tx_latency, ahead.percentile(99.0) * 1e-9);
+    }
+    for (const auto* list : { &recorders, &dsp_recorders })
+    {
+        for (const auto& rec : *list)
+            std::cout << "Recorded " << rec->bytes_written / 1e6 << " MB to " << rec->data_path()
+                << " (" << rec->bytes_written / (elapsed * 1e6) << " MB/s) | Writer stalls: " << rec->stalls << std::endl;
+    }
+    for (size_t i = 0; i < dsps.size(); i++)
+    {
+        const dsp_totals t = dsps[i]->totals();
+        std::cout << "DSP RX ch" << rxs[i]->chan << ": " << t.in_samples << " in -> " << t.out_samples << " decimated";
+        if (t.channel_frames > 0)
+            std::cout << " -> " << t.channel_frames << " x " << cfg.dsp.channels << " channel samples";
+        if (t.fir_ns > 0)
+            std::cout << " | FIR " << t.in_samples * 1e3 / double(t.fir_ns) << " MS/s/core";
+        if (t.channel_ns > 0)
+            std::cout << " | PFB " << t.out_samples * 1e3 / double(t.channel_ns) << " MS/s/core";
+        std::cout << " | Steals: " << t.steals << " | Reordered: " << t.reordered
+            << " | Stalls: " << dsps[i]->stalls << " | Gaps: " << dsps[i]->gaps << std::endl;
+    }
+    if (!rxs.empty())
+    {
+        uint64_t total_timeouts = 0, total_late = 0;
+        for (const auto& rx : rxs)
+        {
+            total_timeouts += rx->metrics.timeouts;
+            total_late += rx->metrics.late_commands;
+        }
+        std::cout << "RX overflows: " << result.rx_overflows
+            << " | Seq errors: " << result.rx_seq_errors
+            << " | Timeouts: " << total_timeouts
+            << " | Late commands: " << total_late
+            << " | Restarts: " << result.rx_restarts << std::endl;
+    }
+    if (!txs.empty())
+    {
+        uint64_t total_acks = 0;
+        for (const auto& tx : txs)
+            total_acks += tx->async.burst_acks;
+        std::cout << "TX underflows: " << result.tx_underflows
+            << " | Seq errors: " << result.tx_seq_errors
+            << " | Time errors: " << result.tx_time_errors
+            << " | Burst ACKs: " << total_acks << std::endl;
+    }
+    if (cfg.convert)
+        std::cout << "Converted " << total_converted << " " << cfg.cpu_format
+            << " samples to fc32 (" << convert_impl_name() << ")" << std::endl;
+    if (loopback)
+        std::cout << "Loopback: " << loopback->markers << " markers / "
+            << txs.front()->metrics.samples / frame_len << " frames sent"
+            << " | Missed: " << loopback->missed
+            << " | Slips: " << loopback->slips
+            << " | Lost samples: " << loopback->lost_samples
+            << " | Path delay: " << loopback->path_latency.percentile(50.0) * 1e-9 * loopback->rate()
+            << " samples" << std::endl;
+    for (size_t i = 0; i < psds.size(); i++)
+    {
+        std::cout << "PSD RX ch" << rxs[i]->chan << " (" << psds[i]->fft_size() << "-point, "
+            << psds[i]->gaps << " gaps)";
+        print_psd(*psds[i]);
+        std::cout << std::endl;
+    }
+    // ƽףÿƵһУͨһ
+    if (!psds.empty() && !cfg.psd_csv.empty())
+    {
+        std::ofstream csv(cfg.psd_csv);
+        if (!csv)
+            throw std::runtime_error("Cannot open " + cfg.psd_csv);
+        std::vector<std::vector<float>> spectra;
+        csv << "freq_hz";
+        for (size_t i = 0; i < psds.size(); i++)
+        {
+            spectra.push_back(psds[i]->spectrum_db());
+            csv << ",rx" << rxs[i]->chan << "_dbfs";
+        }
+        csv << "\n";
+        const size_t n = psds.front()->fft_size();
+        for (size_t k = 0; k < n; k++)
+        {
+            csv << (double(k) - double(n / 2)) * psds.front()->rate() / double(n);
+            for (const auto& s : spectra)
+                csv << "," << s[k];
+            csv << "\n";
+        }
+        std::cout << "Wrote averaged spectrum to " << cfg.psd_csv << std::endl;
+    }
+
+    // úʱֲͬͨϲͳ
+    latency_histogram send_latency, recv_latency, send_ahead, relay_used;
+    for (const auto& tx : txs)
+    {
+        send_latency.merge(tx->metrics.send_latency);
+        send_ahead.merge(tx->metrics.send_ahead);
+        relay_used.merge(tx->relay.budget_used);
+    }
+    for (const auto& rx : rxs)
+        recv_latency.merge(rx->metrics.recv_latency);
+    std::cout << "Call latency (us):\n" << std::setw(24) << "calls" << std::setw(10) << "p50"
+        << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(10) << "max" << "\n";
+    if (!txs.empty())
+        print_latency("send()", send_latency);
+    if (send_ahead.count() > 0)
+        print_latency("tx ahead", send_ahead);
+    if (relay_used.count() > 0)
+        print_latency("relay", relay_used);
+    if (!rxs.empty())
+        print_latency("recv()", recv_latency);
+    if (loopback)
+    {
+        print_latency("loop path", loopback->path_latency);
+        print_latency("loop host", loopback->host_latency);
+    }
+
+    // ÿͨϼƣrecv()ĺʱȴݵʱ䣬CPUʱֻ߳
+    std::cout << "Call overhead (all channels):\n" << std::setw(24) << "calls/s" << std::setw(12) << "samps/call"
+        << std::setw(10) << "us/call" << std::setw(10) << "CPU us" << std::setw(10) << "CPU/samp" << "\n";
+    if (!txs.empty())
+        print_calls("send()", result.tx_calls, result.tx_samples, result.tx_call_ns, result.tx_cpu_ns, elapsed);
+    if (!rxs.empty())
+        print_calls("recv()", result.rx_calls, result.rx_samples, result.rx_call_ns, result.rx_cpu_ns, elapsed);
+    std::cout << std::flush;
+
+    if (cfg.results != nullptr)
+    {
+        result_record r;
+        r.add("time", utc_timestamp());
+        r.append(meta);
+        r.add("elapsed", elapsed);
+        r.add("tx.mbps", result.tx_mbps);
+        r.add("rx.mbps", result.rx_mbps);
+        r.add("tx.samples", result.tx_samples);
+        r.add("tx.errors", result.tx_errors);
+        r.add("tx.underflows", result.tx_underflows);
+        r.add("tx.seq_errors", result.tx_seq_errors);
+        r.add("tx.time_errors", result.tx_time_errors);
+        r.add("rx.samples", result.rx_samples);
+        r.add("rx.errors", result.rx_errors);
+        r.add("rx.overflows", result.rx_overflows);
+        r.add("rx.seq_errors", result.rx_seq_errors);
+        r.add("rx.restarts", result.rx_restarts);
+        r.add("rx.drops", result.drops);
+        r.add("rx.ring_high_water", ring_high_water);
+        r.add("rx.drained_samples", result.rx_drained);
+        r.add("tx.eob_acks", uint64_t(eob_acks));
+        r.add("shutdown_s", shutdown);
+        if (!txs.empty())
+            add_latency(r, "send_latency", send_latency);
+        if (cfg.relay.enabled())
+        {
+            r.add("relay.late", result.relay_late);
+            r.add("relay.min_slack_s", result.relay_slack);
+            add_latency(r, "relay_budget_used", relay_used);
+        }
+        if (send_ahead.count() > 0)
+        {
+            r.add("tx.flow_depth", result.tx_flow_depth);
+            add_latency(r, "tx_latency", send_ahead);
+        }
+        if (!rxs.empty())
+            add_latency(r, "recv_latency", recv_latency);
+        if (loopback)
+        {
+            add_latency(r, "loop_path_latency", loopback->path_latency);
+            add_latency(r, "loop_host_latency", loopback->host_latency);
+        }
+        add_counters(r, txs, rxs);
+        cfg.results->write("summary", r);
+    }
+    return result;
+}
+
+void dsp_scaling(const test_config& cfg, const std::vector<size_t>& thread_counts)
+{
+    const size_t batch_base = (cfg.samps_per_buffer != 0) ? cfg.samps_per_buffer : DEFAULT_BATCH;
+    const size_t block = (cfg.rx_batch != 0) ? cfg.rx_batch : batch_base * 4;
+    std::vector<std::complex<float>> input(block);
+    signal_generator gen(cfg.signal, cfg.sample_rate, cfg.seed);
+    gen.generate(input.data(), block, "fc32");
+
+    struct point
+    {
+        size_t threads;
+        double rate;
+        double elapsed;
+        dsp_totals totals;
+        uint64_t stalls;
+    };
+    std::vector<point> points;
+    for (size_t threads : thread_counts)
+    {
+        dsp_params params = cfg.dsp;
+        params.threads = threads;
+        buffer_arena arena(dsp_stage::arena_bytes(params, block), cfg.huge_pages);
+        dsp_stage stage(params, block, arena, cfg.dsp_thread);
+
+        // ύֻܹ߳߳
+        int64_t index = 0;
+        const auto t0 = std::chrono::steady_clock::now();
+        const auto deadline = t0 + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(cfg.run_time));
+        while (std::chrono::steady_clock::now() < deadline && !interrupted)
+        {
+            for (int i = 0; i < 16; i++)
+            {
+                stage.submit(input.data(), block, index);
+                index += int64_t(block);
+            }
+        }
+        stage.finish();
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        points.push_back({ threads, double(index) / elapsed, elapsed, stage.totals(), stage.stalls });
+        std::cout << "  " << threads << " threads: " << points.back().rate / 1e6 << " MS/s" << std::endl;
+
+        if (cfg.results != nullptr)
+        {
+            result_record r;
+            r.add("time", utc_timestamp());
+            r.add("run_id", run_id);
+            add_host_info(r);
+            add_config(r, cfg);
+            r.add("dsp.threads", uint64_t(threads));
+            r.add("dsp.block", uint64_t(block));
+            r.add("dsp.elapsed", elapsed);
+            r.add("dsp.msps", points.back().rate / 1e6);
+            r.add("dsp.steals", points.back().totals.steals);
+            r.add("dsp.reordered", points.back().totals.reordered);
+            r.add("dsp.busy_ns", points.back().totals.busy_ns);
+            r.add("dsp.stalls", points.back().stalls);
+            cfg.results->write("dsp_scaling", r);
+        }
+    }
+
+    std::cout << "\nDSP scaling (" << block << "-sample blocks, decim " << cfg.dsp.decim;
+    if (cfg.dsp.channels > 1)
+        std::cout << ", " << cfg.dsp.channels << " channels";
+    std::cout << ", " << fir_impl_name() << ")\n"
+        << std::setw(8) << "threads" << std::setw(12) << "MS/s" << std::setw(10) << "speedup"
+        << std::setw(12) << "efficiency" << std::setw(10) << "x rate" << std::setw(10) << "busy %"
+        << std::setw(10) << "steals" << std::setw(10) << "reorder" << std::setw(10) << "stalls" << "\n";
+    for (const point& p : points)
+    {
+        const double speedup = p.rate / points.front().rate;
+        std::cout << std::setw(8) << p.threads << std::fixed << std::setprecision(1)
+            << std::setw(12) << p.rate / 1e6
+            << std::setw(10) << speedup
+            << std::setw(11) << 100.0 * speedup * double(points.front().threads) / double(p.threads) << "%"
+            << std::setw(10) << p.rate / cfg.sample_rate
+            << std::setw(10) << 100.0 * double(p.totals.busy_ns) / (p.elapsed * 1e9 * double(p.threads))
+            << std::setw(10) << p.totals.steals
+            << std::setw(10) << p.totals.reordered
+            << std::setw(10) << p.stalls << "\n";
+    }
+    std::cout.unsetf(std::ios::fixed);
+    std::cout << std::setprecision(6) << std::flush;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "device_setup.h"
+#include "rx_stream.h"
+#include "stream_config.h"
+#include "tx_stream.h"
+#include <cstdint>
+
+// βԽ
+struct trial_result
+{
+    double tx_mbps = 0;
+    double rx_mbps = 0;
+    uint64_t tx_samples = 0;
+    uint64_t rx_samples = 0;
+    uint64_t tx_errors = 0;
+    uint64_t tx_underflows = 0;
+    uint64_t tx_seq_errors = 0;
+    uint64_t tx_time_errors = 0;
+    uint64_t rx_errors = 0;
+    uint64_t rx_overflows = 0;
+    uint64_t rx_seq_errors = 0;
+    uint64_t rx_restarts = 0;
+    uint64_t drops = 0;
+    uint64_t rx_drained = 0;        // ͣſյ
+    size_t tx_eob_acks = 0;         // ֹͣʱյͻACKķͨ
+    double shutdown = 0;            // ӿʼֹͣ߳˳ʱ()
+    double startup = 0;             // 򿪺豸ʱ()
+    uint64_t tx_flow_depth = 0;     // Ӧյķǰ()ͨȡδʱΪ0
+    double tx_latency = 0;          // ӦʱƵķӳp99()ͨȡ
+    uint64_t relay_late = 0;        // мģʽ³ٵĿ
+    double relay_slack = 0;         // мģʽС()ֵʾпٵ
+
+    // ÿ
+    size_t tx_batch = 0;
+    size_t rx_batch = 0;
+    double elapsed = 0;
+    uint64_t tx_calls = 0;
+    uint64_t rx_calls = 0;
+    uint64_t tx_call_ns = 0;
+    uint64_t rx_call_ns = 0;
+    uint64_t tx_cpu_ns = 0;
+    uint64_t rx_cpu_ns = 0;
+};
+
+// cfgһԣ豸շrun_timeֹͣ
+// run_timeΪ0ʱһֱУֱrequest_stop()
+trial_result run_trial(const test_config& cfg);
+
+// е飬֮һʼͽ
+// ѵȴߣźŴеãPOSIXsigwait()̵߳ãWindowsɿ̵̨߳
+void request_stop();
+
+// Ƿѵùrequest_stop()
+bool stop_requested();
+
+// 豸ڴٶDSPύ飬ÿ߳run_time룬ӡ߳չ
+void dsp_scaling(const test_config& cfg, const std::vector<size_t>& thread_counts);
@@ -0,0 +1,106 @@
+#include "thread_placement.h"
+#include <uhd/utils/thread.hpp>
+#include <fstream>
+#include <sstream>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#endif
+
+void apply_placement(const thread_placement& placement)
+{
+    if (!placement.cpus.empty())
+        uhd::set_thread_affinity(placement.cpus);
+    if (placement.priority >= 0)
+        uhd::set_thread_priority_safe(float(placement.priority), placement.priority > 0);
+}
+
+int64_t thread_cpu_ns()
+{
+#if defined(_WIN32)
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+        return 0;
+    // FILETIME100nsΪλ
+    const uint64_t k = (uint64_t(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+    const uint64_t u = (uint64_t(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+    return int64_t((k + u) * 100);
+#else
+    timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+        return 0;
+    return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+int64_t thread_cpu_ns(std::thread& t)
+{
+#if defined(_WIN32)
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(HANDLE(t.native_handle()), &creation, &exit, &kernel, &user))
+        return 0;
+    const uint64_t k = (uint64_t(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+    const uint64_t u = (uint64_t(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+    return int64_t((k + u) * 100);
+#else
+    clockid_t clock;
+    timespec ts;
+    if (pthread_getcpuclockid(t.native_handle(), &clock) != 0 || clock_gettime(clock, &ts) != 0)
+        return 0;
+    return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+std::vector<size_t> numa_node_cpus(int node)
+{
+    std::vector<size_t> cpus;
+    if (node < 0)
+        return cpus;
+
+#if defined(_WIN32)
+    ULONGLONG mask = 0;
+    if (!GetNumaNodeProcessorMask(UCHAR(node), &mask))
+        return cpus;
+    for (size_t cpu = 0; cpu < 64; cpu++)
+    {
+        if (mask & (ULONGLONG(1) << cpu))
+            cpus.push_back(cpu);
+    }
+#elif defined(__linux__)
+    // ʽ"0-7,16-23"
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string list;
+    if (!std::getline(file, list))
+        return cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ','))
+    {
+        if (range.empty())
+            continue;
+        const size_t dash = range.find('-');
+        const size_t first = std::stoul(range.substr(0, dash));
+        const size_t last = (dash == std::string::npos) ? first : std::stoul(range.substr(dash + 1));
+        for (size_t cpu = first; cpu <= last; cpu++)
+            cpus.push_back(cpu);
+    }
+#endif
+    return cpus;
+}
+
+int nic_numa_node(const std::string& iface)
+{
+#if defined(__linux__)
+    // ڵΪ-1
+    std::ifstream file("/sys/class/net/" + iface + "/device/numa_node");
+    int node = -1;
+    if (file >> node)
+        return node;
+#else
+    (void)iface;
+#endif
+    return -1;
+}
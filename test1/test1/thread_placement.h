@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// һ̵߳ĵãɰ󶨵CPUʵʱȼ
+struct thread_placement
+{
+    std::vector<size_t> cpus;  // ձʾ󶨣̳дߵ׺
+    double priority = -1.0;    // ޸ģ0Ϊͨȣ(0, 1]Ϊʵʱ
+
+    // ͬĵindexֻ߳󶨵cpusеһˣʱʹ
+    thread_placement for_thread(size_t index) const
+    {
+        thread_placement p;
+        if (!cpus.empty())
+            p.cpus.push_back(cpus[index % cpus.size()]);
+        p.priority = priority;
+        return p;
+    }
+};
+
+// Եǰ߳Ӧõ
+void apply_placement(const thread_placement& placement);
+
+// ̣߳Ӧõãִf(args...)
+template <typename F, typename... Args>
+std::thread start_thread(const thread_placement& placement, F f, Args&&... args)
+{
+    return std::thread(
+        [placement, f](auto&&... a)
+        {
+            apply_placement(placement);
+            std::invoke(f, std::forward<decltype(a)>(a)...);
+        },
+        std::forward<Args>(args)...);
+}
+
+// ǰ߳ĵCPUʱ(ns)ں̬
+int64_t thread_cpu_ns();
+
+// һе߳ĵCPUʱ(ns)߳̽ٵ
+int64_t thread_cpu_ns(std::thread& t);
+
+// NUMAڵϵCPUбֻ֧ڵ㲻ʱؿ
+std::vector<size_t> numa_node_cpus(int node);
+
+// ڵNUMAڵ㣨Linuxȡsysfsδ֪ʱ-1
+int nic_numa_node(const std::string& iface);
@@ -1,156 +1,652 @@
 #include <uhd/usrp/multi_usrp.hpp>
 #include <uhd/utils/safe_main.hpp>
 #include <uhd/utils/thread.hpp>
-#include <complex>
-#include <chrono>
-#include <atomic>
+#include "convert.h"
+#include "results.h"
+#include "stream_engine.h"
+#include "thread_placement.h"
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <cmath>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
 #include <thread>
 #include <vector>
-#include <queue>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+namespace po = boost::program_options;
 
 namespace
 {
-    // ȫò
-    const double CENTER_FREQ = 1e9;       // 1GHzƵ
-    const double SAMPLE_RATE = 1e6;       // 1MS/s
-    const double TX_GAIN = 15.0;          // 
-    const double RX_GAIN = 20.0;          // 
-    const size_t SAMPS_PER_BUFFER = 4096; // С
-    const double RUN_TIME = 10.0;         // ʱ()
-    const size_t NUM_TX_BUFFERS = 8;      // ͻ
-
-    std::atomic<bool> stop_signal{ false };
-    std::atomic<uint64_t> total_rx_samples{ 0 };
-    std::atomic<uint64_t> total_tx_samples{ 0 };
+    // ãargsӵÿ̨豸ĵַϣ--recv-buff-size/--num-send-frames/--transport-argsʽʱ
+    struct transport_profile
+    {
+        const char* name;
+        const char* args;
+        const char* description;
+    };
+    const transport_profile TRANSPORT_PROFILES[] = {
+        { "default", "", "UHD defaults plus this test's recv_buff_size/num_send_frames" },
+        { "udp", "recv_buff_size=268435456,send_buff_size=268435456,num_recv_frames=512,num_send_frames=512",
+            "kernel UDP with 256MB socket buffers (raise net.core.rmem_max/wmem_max to match)" },
+        { "udp-jumbo", "recv_buff_size=268435456,send_buff_size=268435456,num_recv_frames=512,num_send_frames=512,"
+            "recv_frame_size=8000,send_frame_size=8000", "kernel UDP with 8000-byte frames (needs MTU 9000 on the NIC)" },
+        { "usb3", "num_recv_frames=128,num_send_frames=128,recv_frame_size=16360,send_frame_size=16360",
+            "USB 3 (B2xx) with large bulk transfers" },
+        { "dpdk", "use_dpdk=1,num_recv_frames=512,num_send_frames=512",
+            "DPDK user-space networking; NIC bound to a DPDK driver, per-NIC lcores set in uhd.conf" },
+    };
+
+    const transport_profile* find_transport_profile(const std::string& name)
+    {
+        for (const transport_profile& p : TRANSPORT_PROFILES)
+        {
+            if (name == p.name)
+                return &p;
+        }
+        return nullptr;
+    }
+
+    // жһβǷȶ޽޷Ƿ
+    bool trial_passed(const trial_result& r)
+    {
+        return r.tx_errors == 0 && r.tx_underflows == 0
+            && r.rx_overflows == 0 && r.rx_seq_errors == 0;
+    }
+
+    // ĺѡ㣺ʱ/ȡ
+    struct rate_candidate
+    {
+        double master_clock_rate;
+        size_t decim;
+        double rate;
+    };
+
+#if defined(_WIN32)
+    // ̨Ctrl-Cڵ߳лصֱӻѵȴе߳
+    void on_stop_signal(int sig)
+    {
+        std::signal(sig, SIG_DFL);
+        request_stop();
+    }
+#endif
+
+    // SIGINT/SIGTERMǰ飬ٿʼ飻յһʱֱ˳
+    // request_stop()ҪѵȴߣźŴеãPOSIXһ߳sigwait()źţ
+    // ڴ֮߳ǰã̶̳֮߳źŵ
+    void handle_stop_signals()
+    {
+#if defined(_WIN32)
+        std::signal(SIGINT, on_stop_signal);
+        std::signal(SIGTERM, on_stop_signal);
+#else
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+        std::thread([signals]()
+            {
+                int sig = 0;
+                sigwait(&signals, &sig);
+                request_stop();
+                sigwait(&signals, &sig);
+                std::_Exit(128 + sig);
+            }).detach();
+#endif
+    }
+
+    // ŷָб"0,1""1e6,16e6"ַؿб
+    template <typename T>
+    std::vector<T> parse_list(const std::string& list)
+    {
+        std::vector<std::string> tokens;
+        boost::split(tokens, list, boost::is_any_of("\"',"));
+        std::vector<T> values;
+        for (const std::string& tok : tokens)
+        {
+            if (!tok.empty())
+                values.push_back(boost::lexical_cast<T>(boost::trim_copy(tok)));
+        }
+        return values;
+    }
 }
 
-// ͳ߳
-void stats_thread()
+// г豸ڸʱֵ֧Ĳʣʱ/ȡ
+std::vector<rate_candidate> enumerate_rates(const test_config& cfg,
+    const std::vector<double>& master_clock_rates, size_t max_decim)
 {
-    auto start_time = std::chrono::steady_clock::now();
-    while (!stop_signal)
-    {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-        auto duration = std::chrono::duration<double>(
-            std::chrono::steady_clock::now() - start_time)
-            .count();
-
-        double tx_mbps = (total_tx_samples * sizeof(std::complex<float>) * 8) /
-            (duration * 1e6);
-        double rx_mbps = (total_rx_samples * sizeof(std::complex<float>) * 8) /
-            (duration * 1e6);
-        std::cout << "TX: " << tx_mbps << " Mbps | RX: " << rx_mbps << " Mbps"
-            << " | Samples: " << total_rx_samples
-            << " | Time: " << int(duration) << "s\n";
+    std::vector<rate_candidate> candidates;
+    for (double mcr : master_clock_rates)
+    {
+        test_config probe_cfg = cfg;
+        probe_cfg.master_clock_rate = mcr;
+        // ̽õĻỰڻУʱͬĵһֱӸ
+        auto usrp = open_device(probe_cfg);
+        usrp->set_tx_subdev_spec(uhd::usrp::subdev_spec_t(cfg.subdev));
+        usrp->set_rx_subdev_spec(uhd::usrp::subdev_spec_t(cfg.subdev));
+
+        const double actual_mcr = usrp->get_master_clock_rate();
+        const uhd::meta_range_t tx_rates = usrp->get_tx_rates();
+        const uhd::meta_range_t rx_rates = usrp->get_rx_rates();
+        for (size_t decim = 1; decim <= max_decim; decim++)
+        {
+            // ܾȷõĲʲΪѡ
+            const double rate = actual_mcr / decim;
+            if (std::abs(tx_rates.clip(rate, true) - rate) > 1.0
+                || std::abs(rx_rates.clip(rate, true) - rate) > 1.0)
+                continue;
+            candidates.push_back({ mcr, decim, rate });
+        }
     }
+
+    std::sort(candidates.begin(), candidates.end(),
+        [](const rate_candidate& a, const rate_candidate& b) { return a.rate < b.rate; });
+    candidates.erase(std::unique(candidates.begin(), candidates.end(),
+        [](const rate_candidate& a, const rate_candidate& b) { return std::abs(a.rate - b.rate) < 1.0; }),
+        candidates.end());
+    return candidates;
 }
 
-int UHD_SAFE_MAIN(int argc, char* argv[])
+// ںѡ϶ֲߵȶʣĳһʧܺߵҲʧ
+// غѡ±꣬ȫʧʱcandidates.size()
+size_t search_max_rate(const test_config& cfg, const std::vector<rate_candidate>& candidates,
+    const std::string& mode)
 {
-    uhd::set_thread_priority_safe(1.0, true); // ʵʱȼ
+    size_t lo = 0, hi = candidates.size(); // һʧܵ[lo, hi]
+    while (lo < hi && !stop_requested())
+    {
+        const size_t mid = (lo + hi) / 2;
+        test_config trial_cfg = cfg;
+        trial_cfg.master_clock_rate = candidates[mid].master_clock_rate;
+        trial_cfg.sample_rate = candidates[mid].rate;
 
-    // 1. USRP
-    auto usrp = uhd::usrp::multi_usrp::make(uhd::device_addr_t(""));
-    usrp->set_tx_subdev_spec(uhd::usrp::subdev_spec_t("A:A"));
-    usrp->set_rx_subdev_spec(uhd::usrp::subdev_spec_t("A:A"));
-
-    // Ƶ
-    usrp->set_tx_rate(SAMPLE_RATE);
-    usrp->set_rx_rate(SAMPLE_RATE);
-    usrp->set_tx_freq(CENTER_FREQ);
-    usrp->set_rx_freq(CENTER_FREQ);
-    usrp->set_tx_gain(TX_GAIN);
-    usrp->set_rx_gain(RX_GAIN);
-    usrp->set_clock_source("internal");
-    usrp->set_time_source("internal");
-
-    // 2. ɲźţԤɶ
-    std::vector<std::vector<std::complex<float>>> tx_buffs(NUM_TX_BUFFERS,
-        std::vector<std::complex<float>>(SAMPS_PER_BUFFER));
-    for (auto& buff : tx_buffs)
-    {
-        for (auto& samp : buff)
+        std::cout << "\n=== " << mode << " " << trial_cfg.sample_rate / 1e6 << " MS/s ===" << std::endl;
+        bool passed = false;
+        try
+        {
+            passed = trial_passed(run_trial(trial_cfg));
+        }
+        catch (const std::exception& e)
         {
-            samp = std::complex<float>(
-                (rand() % 2) * 2 - 1,
-                (rand() % 2) * 2 - 1);
+            // 豸ڸò޷Ҳʧ
+            std::cerr << "Trial failed: " << e.what() << std::endl;
         }
+        // жϵ鲻ͨҲʧ
+        if (stop_requested())
+            break;
+        std::cout << "[search] " << mode << " " << trial_cfg.sample_rate / 1e6 << " MS/s: "
+            << (passed ? "PASS" : "FAIL") << std::endl;
+
+        if (passed)
+            lo = mid + 1;
+        else
+            hi = mid;
     }
+    return (lo == 0) ? candidates.size() : lo - 1;
+}
+
+int UHD_SAFE_MAIN(int argc, char* argv[])
+{
+    // κUHDú̴߳UHD־̵֮߳󴴽̶̳߳SIGINT/SIGTERM
+    handle_stop_signals();
 
-    // 3. 
-    uhd::stream_args_t tx_args("fc32");
-    tx_args.args["spp"] = std::to_string(SAMPS_PER_BUFFER);
-    tx_args.args["num_send_frames"] = "32"; // ӷ֡
-    auto tx_stream = usrp->get_tx_stream(tx_args);
+    // 豸Ựmain()ǰر
+    device_cache_scope device_cache;
 
-    uhd::stream_args_t rx_args("fc32");
-    rx_args.args["recv_buff_size"] = "16777216"; // 16MBջ
-    auto rx_stream = usrp->get_rx_stream(rx_args);
+    // в
+    test_config cfg;
+    std::string config_file, tx_channel_list, rx_channel_list, sweep_spp, sweep_recv_buff, sweep_batch, search_mcr, dsp_scaling_list;
+    std::string transport_args, dpdk_corelist, dpdk_main_core;
+    std::string results_path, results_format = "json";
+    bool list_transports = false;
+    bool fresh_device = false;
+    std::string tx_cpus, async_cpus, rx_cpus, consumer_cpus, stats_cpus, writer_cpus, prefetch_cpus, dsp_cpus, nic;
+    double prefetch_ahead_mb = 64;
+    bool no_huge_pages = false;
+    bool search_rate = false;
+    size_t search_max_decim = 512;
 
-    // 4. ͳ߳
-    std::thread stats(stats_thread);
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help", "help message")
+        ("config", po::value<std::string>(&config_file), "read options from a file (one \"name = value\" per line)")
+        ("args", po::value<std::vector<std::string>>(&cfg.devices)->multitoken(), "device address; repeat for multiple devices")
+        ("subdev", po::value<std::string>(&cfg.subdev)->default_value("A:A"), "subdevice spec applied to every device, e.g. \"A:A A:B\"")
+        ("tx-channels", po::value<std::string>(&tx_channel_list)->default_value("0"), "TX channels, e.g. \"0,1\"; empty disables TX")
+        ("rx-channels", po::value<std::string>(&rx_channel_list)->default_value("0"), "RX channels, e.g. \"0,1\"; empty disables RX")
+        ("freq", po::value<double>(&cfg.center_freq)->default_value(cfg.center_freq), "center frequency in Hz")
+        ("rate", po::value<double>(&cfg.sample_rate)->default_value(cfg.sample_rate), "TX/RX sample rate in samples/s")
+        ("master-clock-rate", po::value<double>(&cfg.master_clock_rate)->default_value(cfg.master_clock_rate), "master clock rate in Hz; 0 keeps the device default")
+        ("tx-gain", po::value<double>(&cfg.tx_gain)->default_value(cfg.tx_gain), "TX gain in dB")
+        ("rx-gain", po::value<double>(&cfg.rx_gain)->default_value(cfg.rx_gain), "RX gain in dB")
+        ("spp", po::value<size_t>(&cfg.samps_per_buffer)->default_value(cfg.samps_per_buffer), "samples per packet (spp stream arg); 0 leaves it to UHD")
+        ("tx-batch", po::value<size_t>(&cfg.tx_batch)->default_value(cfg.tx_batch), "samples per send() call; 0 uses spp")
+        ("rx-batch", po::value<size_t>(&cfg.rx_batch)->default_value(cfg.rx_batch), "samples requested per recv() call; 0 uses 4 * spp")
+        ("duration", po::value<double>(&cfg.run_time)->default_value(cfg.run_time), "run time of each trial in seconds; 0 runs until SIGINT/SIGTERM")
+        ("tx-buffers", po::value<size_t>(&cfg.num_tx_buffers)->default_value(cfg.num_tx_buffers), "number of pre-generated TX buffers")
+        ("transport", po::value<std::string>(&cfg.transport)->default_value(cfg.transport), "transport profile: default, udp, udp-jumbo, usb3 or dpdk (see --list-transports)")
+        ("transport-args", po::value<std::string>(&transport_args), "extra transport args overriding the profile, e.g. \"num_recv_frames=1024\"")
+        ("dpdk-corelist", po::value<std::string>(&dpdk_corelist), "DPDK lcores for the dpdk profile, e.g. \"2,3,4\"")
+        ("dpdk-main-core", po::value<std::string>(&dpdk_main_core), "DPDK main lcore for the dpdk profile")
+        ("list-transports", po::bool_switch(&list_transports), "list the transport profiles and exit")
+        ("num-send-frames", po::value<size_t>(&cfg.num_send_frames)->default_value(cfg.num_send_frames), "transport send frame count")
+        ("tx-latency", po::value<double>(&cfg.tx_flow.target_latency)->default_value(cfg.tx_flow.target_latency), "adaptive TX flow control: keep about this many seconds of samples queued ahead of the device instead of letting send() fill every buffer; 0 disables. --tx-batch becomes the upper bound per call (default 8 * spp)")
+        ("tx-max-latency", po::value<double>(&cfg.tx_flow.max_latency)->default_value(cfg.tx_flow.max_latency), "upper bound in seconds for the adaptive TX send-ahead depth")
+        ("tx-flow-backoff", po::value<double>(&cfg.tx_flow.backoff)->default_value(cfg.tx_flow.backoff), "multiply the TX send-ahead depth by this factor after an underflow")
+        ("tx-flow-probe", po::value<double>(&cfg.tx_flow.probe_interval)->default_value(cfg.tx_flow.probe_interval), "after this many seconds without underflow, lower the TX send-ahead depth by about 10% toward --tx-latency")
+        ("recv-buff-size", po::value<size_t>(&cfg.recv_buff_size)->default_value(cfg.recv_buff_size), "transport receive buffer size in bytes")
+        ("zero-copy", po::bool_switch(&cfg.zero_copy), "recv directly into ring slots (no staging copy)")
+        ("format", po::value<std::string>(&cfg.cpu_format)->default_value("fc32"), "host sample format: fc32, sc16 or sc8")
+        ("convert", po::bool_switch(&cfg.convert), "convert sc16/sc8 to fc32 in the consumer thread instead of in UHD")
+        ("clock-source", po::value<std::string>(&cfg.clock_source)->default_value(cfg.clock_source), "reference clock source: internal, external or gpsdo")
+        ("time-source", po::value<std::string>(&cfg.time_source)->default_value(cfg.time_source), "time (PPS) source: internal, external or gpsdo")
+        ("time-sync", po::value<std::string>(&cfg.time_sync)->default_value(cfg.time_sync), "none starts streams immediately; now or pps sets device time and starts all TX/RX streams at the same device time")
+        ("start-delay", po::value<double>(&cfg.start_delay)->default_value(cfg.start_delay), "seconds after the current device time for the timed start")
+        ("fresh-device", po::bool_switch(&fresh_device), "open a new device session for every trial instead of reusing the previous one when the device args are unchanged")
+        ("retune-lead", po::value<double>(&cfg.retune_lead)->default_value(cfg.retune_lead), "on a reused device session, retune all channels of a device with a timed command this many seconds ahead; 0 retunes immediately")
+        ("record", po::value<std::string>(&cfg.record_base), "record RX samples to <base>.sigmf-data/.sigmf-meta (<base>_ch<N> for multiple channels)")
+        ("writer-cpus", po::value<std::string>(&writer_cpus), "cores for the recorder's disk writer threads")
+        ("writer-priority", po::value<double>(&cfg.writer_thread.priority)->default_value(cfg.writer_thread.priority), "disk writer thread priority")
+        ("signal", po::value<std::string>(&cfg.signal.kind)->default_value(cfg.signal.kind), "TX test signal: qpsk, qam16, qam64, qam256, tone, chirp, pn or noise")
+        ("signal-amp", po::value<double>(&cfg.signal.amplitude)->default_value(cfg.signal.amplitude), "peak amplitude per I/Q component, 1.0 is full scale")
+        ("signal-freq", po::value<double>(&cfg.signal.freq)->default_value(cfg.signal.freq), "tone frequency offset in Hz")
+        ("chirp-bw", po::value<double>(&cfg.signal.chirp_bw)->default_value(cfg.signal.chirp_bw), "chirp sweep bandwidth in Hz; 0 uses 0.8 * rate")
+        ("chirp-period", po::value<double>(&cfg.signal.chirp_period)->default_value(cfg.signal.chirp_period), "chirp sweep period in seconds")
+        ("signal-pn-order", po::value<int>(&cfg.signal.pn_order)->default_value(cfg.signal.pn_order), "pn signal length 2^order-1, order 5..15")
+        ("snr", po::value<double>(&cfg.signal.snr_db), "add white Gaussian noise at this SNR in dB")
+        ("seed", po::value<uint64_t>(&cfg.seed)->default_value(cfg.seed), "signal generator seed")
+        ("live-signal", po::bool_switch(&cfg.live_signal), "generate every TX buffer just before send() instead of cycling through --tx-buffers fixed buffers")
+        ("playback", po::value<std::string>(&cfg.playback_path), "transmit samples from a raw IQ file in --format, or a .sigmf-data/.sigmf-meta recording, instead of generated buffers")
+        ("playback-loop", po::bool_switch(&cfg.playback_loop), "restart the playback file from the beginning when it ends")
+        ("prefetch-threads", po::value<size_t>(&cfg.prefetch_threads)->default_value(cfg.prefetch_threads), "threads that fault in the playback file ahead of the TX thread; 0 relies on kernel readahead")
+        ("prefetch-ahead", po::value<double>(&prefetch_ahead_mb)->default_value(prefetch_ahead_mb), "playback prefetch window in MB")
+        ("prefetch-cpus", po::value<std::string>(&prefetch_cpus), "cores for the playback prefetch threads")
+        ("loopback", po::bool_switch(&cfg.loopback), "cabled loopback from the first TX to the first RX channel: send a PN marker each spp * tx-buffers samples and measure latency and sample loss")
+        ("loopback-pn-order", po::value<int>(&cfg.loopback_pn_order)->default_value(cfg.loopback_pn_order), "PN marker length 2^order-1, order 5..15")
+        ("relay-offset", po::value<double>(&cfg.relay.offset)->default_value(cfg.relay.offset), "full-duplex relay: send each received block back out at its RX timestamp plus this many seconds, pairing the i-th RX channel with the i-th TX channel; 0 disables")
+        ("relay-process", po::value<std::string>(&cfg.relay.process)->default_value(cfg.relay.process), "relay processing: copy or gain")
+        ("relay-gain", po::value<double>(&cfg.relay.gain)->default_value(cfg.relay.gain), "linear gain for --relay-process gain; sc16/sc8 saturate")
+        ("dsp-decim", po::value<size_t>(&cfg.dsp.decim)->default_value(cfg.dsp.decim), "decimate each RX channel by this factor with a polyphase FIR after the ring; implies fc32 conversion")
+        ("dsp-taps", po::value<size_t>(&cfg.dsp.taps)->default_value(cfg.dsp.taps), "FIR decimator taps; 0 uses 8 * dsp-decim")
+        ("dsp-channels", po::value<size_t>(&cfg.dsp.channels)->default_value(cfg.dsp.channels), "split the decimated stream into this many channels (power of two) with a polyphase FFT channelizer; 0 disables")
+        ("dsp-channel-taps", po::value<size_t>(&cfg.dsp.channel_taps)->default_value(cfg.dsp.channel_taps), "channelizer prototype taps per channel")
+        ("dsp-threads", po::value<size_t>(&cfg.dsp.threads)->default_value(cfg.dsp.threads), "DSP worker threads per RX channel; blocks go to a work-stealing pool whose idle workers steal from busy ones, and a reorder stage emits the results in sequence order")
+        ("dsp-cpus", po::value<std::string>(&dsp_cpus), "cores for the DSP worker threads")
+        ("dsp-record", po::value<std::string>(&cfg.dsp_record_base), "record the DSP stage output in order as fc32 <base>.sigmf-data/.sigmf-meta (<base>_ch<N> for multiple channels)")
+        ("dsp-scaling", po::value<std::string>(&dsp_scaling_list), "without a device, feed the DSP stage from memory for --duration seconds per thread count, e.g. \"1,2,4,8\", and print the scaling curve")
+        ("dsp-priority", po::value<double>(&cfg.dsp_thread.priority)->default_value(cfg.dsp_thread.priority), "DSP worker thread priority")
+        ("psd-fft", po::value<size_t>(&cfg.psd.fft_size)->default_value(cfg.psd.fft_size), "monitor each RX channel's averaged spectrum with this FFT size (power of two) plus RMS/peak power; 0 disables")
+        ("psd-avg", po::value<double>(&cfg.psd.alpha)->default_value(cfg.psd.alpha), "PSD exponential averaging factor in (0, 1]")
+        ("psd-frames", po::value<double>(&cfg.psd.frames_per_sec)->default_value(cfg.psd.frames_per_sec), "at most this many FFT frames per second; the other samples only count towards power; 0 analyzes every frame")
+        ("psd-interval", po::value<double>(&cfg.psd.publish_interval)->default_value(cfg.psd.publish_interval), "seconds of samples per published PSD/power snapshot")
+        ("psd-csv", po::value<std::string>(&cfg.psd_csv), "write the final averaged spectrum of every RX channel to this CSV file")
+        ("metrics-port", po::value<int>(&cfg.exporter.http_port)->default_value(cfg.exporter.http_port), "serve every counter, ring depth, per-thread CPU time and latency quantiles in Prometheus text format on this HTTP port (GET /metrics); 0 disables")
+        ("metrics-bind", po::value<std::string>(&cfg.exporter.http_bind)->default_value(cfg.exporter.http_bind), "address the --metrics-port server listens on")
+        ("statsd", po::value<std::string>(&cfg.exporter.statsd), "push the same metrics to a StatsD server at host:port over UDP")
+        ("statsd-interval", po::value<double>(&cfg.exporter.statsd_interval)->default_value(cfg.exporter.statsd_interval), "seconds between StatsD pushes")
+        ("metrics-prefix", po::value<std::string>(&cfg.exporter.prefix)->default_value(cfg.exporter.prefix), "prefix of every exported metric name")
+        ("no-huge-pages", po::bool_switch(&no_huge_pages), "back the sample buffers with 4KB pages instead of 2MB huge pages")
+        ("rx-restart-errors", po::value<size_t>(&cfg.rx_restart_errors)->default_value(cfg.rx_restart_errors), "restart RX streaming after this many consecutive recv errors; 0 disables")
+        ("rx-restart-delay", po::value<double>(&cfg.rx_restart_delay)->default_value(cfg.rx_restart_delay), "seconds ahead of device time for the timed restart")
+        ("shutdown-timeout", po::value<double>(&cfg.shutdown_timeout)->default_value(cfg.shutdown_timeout), "at stop, wait at most this many seconds for each TX burst ACK and for draining the in-flight RX packets")
+        ("tx-cpus", po::value<std::string>(&tx_cpus), "cores for the TX threads, e.g. \"2,3\"; TX thread i uses the i-th core")
+        ("async-cpus", po::value<std::string>(&async_cpus), "cores for the TX async message threads")
+        ("rx-cpus", po::value<std::string>(&rx_cpus), "cores for the RX (recv) threads")
+        ("consumer-cpus", po::value<std::string>(&consumer_cpus), "cores for the RX consumer/convert threads")
+        ("stats-cpus", po::value<std::string>(&stats_cpus), "core for the stats thread")
+        ("tx-priority", po::value<double>(&cfg.tx_thread.priority)->default_value(cfg.tx_thread.priority), "TX thread priority: (0,1] real-time, 0 normal, <0 unchanged")
+        ("async-priority", po::value<double>(&cfg.async_thread.priority)->default_value(cfg.async_thread.priority), "TX async message thread priority")
+        ("rx-priority", po::value<double>(&cfg.rx_thread.priority)->default_value(cfg.rx_thread.priority), "RX thread priority")
+        ("consumer-priority", po::value<double>(&cfg.consumer_thread.priority)->default_value(cfg.consumer_thread.priority), "RX consumer thread priority")
+        ("stats-priority", po::value<double>(&cfg.stats_thread.priority)->default_value(cfg.stats_thread.priority), "stats thread priority")
+        ("numa-node", po::value<int>(&cfg.numa_node)->default_value(cfg.numa_node), "NUMA node to run on and allocate buffers from; -1 disables")
+        ("nic", po::value<std::string>(&nic), "network interface to the device, e.g. \"enp1s0f0\"; sets --numa-node to its node")
+        ("sweep-spp", po::value<std::string>(&sweep_spp), "sweep spp over a list, e.g. \"512,1024,2048,4096,8192\"")
+        ("sweep-recv-buff", po::value<std::string>(&sweep_recv_buff), "sweep recv-buff-size over a list, e.g. \"1e6,16e6,256e6\"")
+        ("sweep-batch", po::value<std::string>(&sweep_batch), "sweep the send()/recv() batch size over a list, e.g. \"512,2048,8192,32768\", and report call overhead")
+        ("search-rate", po::bool_switch(&search_rate), "binary-search the highest stable rate for TX only, RX only and full duplex; each trial runs --duration seconds")
+        ("search-mcr", po::value<std::string>(&search_mcr), "master clock rates to search, e.g. \"200e6,184.32e6\"; default is the device default")
+        ("search-max-decim", po::value<size_t>(&search_max_decim)->default_value(search_max_decim), "largest decimation to consider in the rate search")
+        ("results", po::value<std::string>(&results_path), "write a record every stats interval and a summary per trial, with the full configuration, host, UHD version and device serials")
+        ("results-format", po::value<std::string>(&results_format)->default_value(results_format), "json appends JSON lines to the --results file; csv writes <name>.interval.csv and <name>.summary.csv")
+        ;
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    if (vm.count("config"))
+    {
+        std::ifstream file(vm["config"].as<std::string>());
+        if (!file)
+            throw std::runtime_error("Cannot open config file: " + vm["config"].as<std::string>());
+        // ȣstoreḲеֵ
+        po::store(po::parse_config_file(file, desc), vm);
+    }
+    po::notify(vm);
+
+    if (vm.count("help"))
+    {
+        std::cout << "UHD TX/RX throughput test " << desc << std::endl;
+        return ~0;
+    }
 
-    // 5. 첽߳
-    std::atomic<bool> tx_done{ false };
-    std::thread tx_thread([&]()
+    if (list_transports)
+    {
+        for (const transport_profile& p : TRANSPORT_PROFILES)
+            std::cout << std::left << std::setw(12) << p.name << std::right << p.description << "\n"
+                << std::setw(12) << "" << (*p.args ? p.args : "(no extra args)") << "\n";
+        std::cout << std::flush;
+        return 0;
+    }
+
+    // ãrecv_buff_sizenum_send_framesҲϣδָʱȡеֵ
+    const transport_profile* profile = find_transport_profile(cfg.transport);
+    if (profile == nullptr)
+        throw std::runtime_error("Unknown --transport: " + cfg.transport + " (see --list-transports)");
+    uhd::device_addr_t profile_args(profile->args);
+    const uhd::device_addr_t override_args(transport_args);
+    for (const std::string& key : override_args.keys())
+        profile_args[key] = override_args[key];
+    if (cfg.transport == "dpdk")
+    {
+        if (!dpdk_corelist.empty())
+            profile_args["dpdk_corelist"] = dpdk_corelist;
+        if (!dpdk_main_core.empty())
+            profile_args["dpdk_main_core"] = dpdk_main_core;
+    }
+    else if (!dpdk_corelist.empty() || !dpdk_main_core.empty())
+        throw std::runtime_error("--dpdk-corelist/--dpdk-main-core need --transport dpdk");
+    for (const std::string& key : profile_args.keys())
+    {
+        if (key == "recv_buff_size")
         {
-            uhd::tx_metadata_t md;
-            md.start_of_burst = true;
-            md.end_of_burst = false;
+            if (vm["recv-buff-size"].defaulted() || override_args.has_key(key))
+                cfg.recv_buff_size = profile_args.cast<size_t>(key, cfg.recv_buff_size);
+        }
+        else if (key == "num_send_frames")
+        {
+            if (vm["num-send-frames"].defaulted() || override_args.has_key(key))
+                cfg.num_send_frames = profile_args.cast<size_t>(key, cfg.num_send_frames);
+        }
+        else
+            cfg.transport_args[key] = profile_args[key];
+    }
 
-            size_t buff_idx = 0;
-            size_t num_sent = 0;
-            const double timeout = 0.1; // ޸óʱʱΪ100ms
+    cfg.bytes_per_samp = bytes_per_sample(cfg.cpu_format);
+    if (cfg.bytes_per_samp == 0)
+        throw std::runtime_error("Unsupported --format: " + cfg.cpu_format);
+    if (cfg.num_tx_buffers == 0)
+        throw std::runtime_error("--tx-buffers must be non-zero");
+    // fc32ת
+    cfg.convert = cfg.convert && cfg.cpu_format != "fc32";
+    cfg.huge_pages = !no_huge_pages;
 
-            while (!tx_done) {
-                const auto& buff = tx_buffs[buff_idx];
-                num_sent = tx_stream->send(buff.data(), buff.size(), md, timeout);
+    if (cfg.devices.empty())
+        cfg.devices.push_back("");
+    cfg.tx_chans = parse_list<size_t>(tx_channel_list);
+    cfg.rx_chans = parse_list<size_t>(rx_channel_list);
 
-                if (num_sent < buff.size()) {
-                    std::cerr << "TX Underflow! Sent " << num_sent << "/" << buff.size() << std::endl;
-                }
+    if (cfg.time_sync != "none" && cfg.time_sync != "now" && cfg.time_sync != "pps")
+        throw std::runtime_error("Unsupported --time-sync: " + cfg.time_sync);
+    // Ҫշͬһ豸ʱ̿ʼɽʱӳ
+    if (cfg.loopback)
+    {
+        if (cfg.tx_chans.empty() || cfg.rx_chans.empty())
+            throw std::runtime_error("--loopback needs at least one TX and one RX channel");
+        if (cfg.time_sync == "none")
+            cfg.time_sync = "now";
+    }
+    if (cfg.loopback && !cfg.playback_path.empty())
+        throw std::runtime_error("--loopback and --playback cannot be combined");
+    if (cfg.live_signal && (cfg.loopback || !cfg.playback_path.empty()))
+        throw std::runtime_error("--live-signal cannot be combined with --loopback or --playback");
+    if (cfg.time_sync != "none" && cfg.start_delay <= 0)
+        throw std::runtime_error("--start-delay must be positive for a timed start");
+    if (cfg.dsp.decim == 0 || cfg.dsp.threads == 0 || cfg.dsp.channel_taps == 0)
+        throw std::runtime_error("--dsp-decim, --dsp-threads and --dsp-channel-taps must be non-zero");
+    if (cfg.dsp.channels > 1 && (cfg.dsp.channels & (cfg.dsp.channels - 1)) != 0)
+        throw std::runtime_error("--dsp-channels must be a power of two");
+    if (cfg.psd.fft_size == 1 || (cfg.psd.fft_size & (cfg.psd.fft_size - 1)) != 0)
+        throw std::runtime_error("--psd-fft must be a power of two");
+    if (cfg.psd.fft_size > 0 && (cfg.psd.alpha <= 0 || cfg.psd.alpha > 1 || cfg.psd.publish_interval <= 0))
+        throw std::runtime_error("--psd-avg must be in (0, 1] and --psd-interval positive");
+    if (cfg.shutdown_timeout < 0)
+        throw std::runtime_error("--shutdown-timeout must not be negative");
+    cfg.reuse_device = !fresh_device;
+    if (cfg.retune_lead < 0)
+        throw std::runtime_error("--retune-lead must not be negative");
+    if (cfg.relay.offset < 0)
+        throw std::runtime_error("--relay-offset must not be negative");
+    if (cfg.relay.enabled())
+    {
+        if (cfg.rx_chans.empty() || cfg.rx_chans.size() != cfg.tx_chans.size())
+            throw std::runtime_error("--relay-offset needs as many TX channels as RX channels");
+        if (cfg.relay.process != "copy" && cfg.relay.process != "gain")
+            throw std::runtime_error("--relay-process must be copy or gain");
+        if (cfg.loopback || cfg.live_signal || !cfg.playback_path.empty() || cfg.tx_flow.enabled())
+            throw std::runtime_error("--relay-offset cannot be combined with --loopback, --live-signal, --playback or --tx-latency");
+        if (cfg.convert || cfg.dsp.enabled() || cfg.psd.fft_size > 0 || !cfg.record_base.empty())
+            throw std::runtime_error("--relay-offset replaces the RX consumer; it cannot be combined with --convert, --dsp-*, --psd-fft or --record");
+    }
+    if (cfg.tx_flow.target_latency < 0)
+        throw std::runtime_error("--tx-latency must not be negative");
+    if (cfg.tx_flow.enabled() && (cfg.tx_flow.max_latency < cfg.tx_flow.target_latency
+        || cfg.tx_flow.backoff <= 1 || cfg.tx_flow.probe_interval <= 0))
+        throw std::runtime_error("--tx-max-latency must be at least --tx-latency, --tx-flow-backoff above 1 and --tx-flow-probe positive");
+    if (cfg.run_time < 0)
+        throw std::runtime_error("--duration must not be negative");
+    if (cfg.exporter.http_port < 0 || cfg.exporter.http_port > 65535)
+        throw std::runtime_error("--metrics-port must be a TCP port number");
+    if (!cfg.exporter.statsd.empty() && cfg.exporter.statsd_interval <= 0)
+        throw std::runtime_error("--statsd-interval must be positive");
+    if (!cfg.dsp_record_base.empty() && !cfg.dsp.enabled())
+        throw std::runtime_error("--dsp-record needs --dsp-decim > 1 or --dsp-channels > 1");
 
-                total_tx_samples += num_sent;
-                buff_idx = (buff_idx + 1) % NUM_TX_BUFFERS;
-                md.start_of_burst = false;
-            }
+    cfg.tx_thread.cpus = parse_list<size_t>(tx_cpus);
+    cfg.async_thread.cpus = parse_list<size_t>(async_cpus);
+    cfg.rx_thread.cpus = parse_list<size_t>(rx_cpus);
+    cfg.consumer_thread.cpus = parse_list<size_t>(consumer_cpus);
+    cfg.stats_thread.cpus = parse_list<size_t>(stats_cpus);
+    cfg.writer_thread.cpus = parse_list<size_t>(writer_cpus);
+    cfg.prefetch_thread.cpus = parse_list<size_t>(prefetch_cpus);
+    cfg.dsp_thread.cpus = parse_list<size_t>(dsp_cpus);
+    cfg.prefetch_ahead = size_t(prefetch_ahead_mb * 1e6);
 
-            md.end_of_burst = true;
-            tx_stream->send("", 0, md); });
+    if (!nic.empty())
+    {
+        cfg.numa_node = nic_numa_node(nic);
+        if (cfg.numa_node < 0)
+            std::cerr << "NUMA node of " << nic << " is unknown; not restricting placement" << std::endl;
+    }
+    // ̰߳󶨵ڽڵ㣺֮󴴽̼̳߳и׺ԣ
+    // ͻ塢ջζкUHD㻺嶼״дʱ䣬˶ڸýڵڴ
+    if (cfg.numa_node >= 0)
+    {
+        const std::vector<size_t> node_cpus = numa_node_cpus(cfg.numa_node);
+        if (node_cpus.empty())
+            throw std::runtime_error("No CPUs found on NUMA node " + std::to_string(cfg.numa_node));
+        uhd::set_thread_affinity(node_cpus);
+        std::cout << "Running on NUMA node " << cfg.numa_node << " (" << node_cpus.size() << " cores)" << std::endl;
+    }
 
-    // 6. ѭ
-    uhd::stream_cmd_t rx_cmd(uhd::stream_cmd_t::STREAM_MODE_START_CONTINUOUS);
-    rx_cmd.stream_now = true;
-    rx_stream->issue_stream_cmd(rx_cmd);
+    uhd::set_thread_priority_safe(1.0, true); // ʵʱȼ
 
-    std::vector<std::complex<float>> rx_buff(SAMPS_PER_BUFFER * 4); // Ľջ
-    auto start_time = std::chrono::steady_clock::now();
+    std::unique_ptr<results_writer> writer;
+    if (!results_path.empty())
+    {
+        writer.reset(new results_writer(results_path, results_format));
+        cfg.results = writer.get();
+    }
 
-    while (std::chrono::duration<double>(
-        std::chrono::steady_clock::now() - start_time)
-        .count() < RUN_TIME)
+    // ɨ衢չɶζ
+    const bool multi_trial = search_rate || !dsp_scaling_list.empty()
+        || !sweep_spp.empty() || !sweep_recv_buff.empty() || !sweep_batch.empty();
+    if (cfg.run_time == 0 && multi_trial)
+        throw std::runtime_error("--duration 0 only applies to a single trial");
+
+    // DSPչߣҪ豸
+    if (!dsp_scaling_list.empty())
+    {
+        if (!cfg.dsp.enabled())
+            throw std::runtime_error("--dsp-scaling needs --dsp-decim > 1 or --dsp-channels > 1");
+        dsp_scaling(cfg, parse_list<size_t>(dsp_scaling_list));
+        return 0;
+    }
+
+    // ȶֱֻֻպȫ˫
+    if (search_rate)
     {
+        std::vector<double> mcr_list = parse_list<double>(search_mcr);
+        if (mcr_list.empty())
+            mcr_list.push_back(cfg.master_clock_rate);
+        const std::vector<rate_candidate> candidates = enumerate_rates(cfg, mcr_list, search_max_decim);
+        if (candidates.empty())
+            throw std::runtime_error("No supported sample rates to search");
 
-        uhd::rx_metadata_t rx_md;
-        size_t num_rx = rx_stream->recv(rx_buff.data(), rx_buff.size(), rx_md); // 
+        struct search_mode
+        {
+            std::string name;
+            std::vector<size_t> tx_chans, rx_chans;
+        };
+        std::vector<search_mode> modes;
+        if (!cfg.tx_chans.empty())
+            modes.push_back({ "TX only", cfg.tx_chans, {} });
+        if (!cfg.rx_chans.empty())
+            modes.push_back({ "RX only", {}, cfg.rx_chans });
+        if (!cfg.tx_chans.empty() && !cfg.rx_chans.empty())
+            modes.push_back({ "Full duplex", cfg.tx_chans, cfg.rx_chans });
 
-        if (rx_md.error_code != uhd::rx_metadata_t::ERROR_CODE_NONE)
+        std::vector<size_t> best;
+        for (const search_mode& mode : modes)
         {
-            std::cerr << "RX Error: " << rx_md.strerror() << std::endl;
-            continue;
+            if (stop_requested())
+                break;
+            test_config mode_cfg = cfg;
+            mode_cfg.tx_chans = mode.tx_chans;
+            mode_cfg.rx_chans = mode.rx_chans;
+            best.push_back(search_max_rate(mode_cfg, candidates, mode.name));
         }
 
-        total_rx_samples += num_rx;
+        std::cout << "\nMax sustainable rate (" << cfg.run_time << " s trials, "
+            << cfg.cpu_format << ", " << cfg.transport << " transport, zero overflows/underflows)\n";
+        for (size_t i = 0; i < best.size(); i++)
+        {
+            std::cout << "  " << std::left << std::setw(12) << modes[i].name << std::right << ": ";
+            if (best[i] == candidates.size())
+            {
+                std::cout << "none (lowest candidate " << candidates.front().rate / 1e6 << " MS/s failed)\n";
+                continue;
+            }
+            const rate_candidate& c = candidates[best[i]];
+            std::cout << c.rate / 1e6 << " MS/s (decim " << c.decim
+                << " of " << c.rate * c.decim / 1e6 << " MHz)\n";
+        }
+        if (stop_requested())
+            std::cout << "  (search interrupted; the last mode searched may be incomplete)\n";
+        std::cout << std::flush;
+        return 0;
     }
 
-    // 7. ֹͣ豸
-    stop_signal = true;
-    tx_done = true;
+    // δָɨʱֻһ
+    std::vector<double> spp_list = parse_list<double>(sweep_spp);
+    std::vector<double> recv_buff_list = parse_list<double>(sweep_recv_buff);
+    std::vector<double> batch_list = parse_list<double>(sweep_batch);
+    if (spp_list.empty() && recv_buff_list.empty() && batch_list.empty())
+    {
+        run_trial(cfg);
+        return 0;
+    }
+    if (spp_list.empty())
+        spp_list.push_back(double(cfg.samps_per_buffer));
+    if (recv_buff_list.empty())
+        recv_buff_list.push_back(double(cfg.recv_buff_size));
+    // 0ʾ--tx-batch/--rx-batch
+    const bool sweeping_batch = !batch_list.empty();
+    if (batch_list.empty())
+        batch_list.push_back(0);
 
-    rx_stream->issue_stream_cmd(uhd::stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS);
-    tx_thread.join();
-    stats.join();
+    // ɨ裺ÿ½豸һΣӡܱ
+    std::vector<std::pair<test_config, trial_result>> results;
+    for (double recv_buff : recv_buff_list)
+    {
+        for (double spp : spp_list)
+        {
+            for (double batch : batch_list)
+            {
+                if (stop_requested())
+                    break;
+                test_config trial_cfg = cfg;
+                trial_cfg.samps_per_buffer = size_t(spp);
+                trial_cfg.recv_buff_size = size_t(recv_buff);
+                if (sweeping_batch)
+                    trial_cfg.tx_batch = trial_cfg.rx_batch = size_t(batch);
+                std::cout << "\n=== spp " << trial_cfg.samps_per_buffer
+                    << ", recv_buff_size " << trial_cfg.recv_buff_size;
+                if (sweeping_batch)
+                    std::cout << ", batch " << trial_cfg.tx_batch;
+                std::cout << " ===" << std::endl;
+                results.emplace_back(trial_cfg, run_trial(trial_cfg));
+            }
+        }
+    }
+
+    std::cout << "\nSweep results (rate " << cfg.sample_rate / 1e6 << " MS/s, "
+        << cfg.cpu_format << ", " << cfg.transport << " transport, " << cfg.run_time << " s per trial)\n"
+        << std::setw(8) << "spp" << std::setw(16) << "recv_buff_size"
+        << std::setw(10) << "TX batch" << std::setw(10) << "RX batch"
+        << std::setw(12) << "TX Mbps" << std::setw(12) << "RX Mbps"
+        << std::setw(10) << "TX err" << std::setw(10) << "Underflow"
+        << std::setw(10) << "RX err" << std::setw(10) << "Overflow"
+        << std::setw(10) << "Drops" << "\n";
+    for (const auto& r : results)
+    {
+        std::cout << std::setw(8) << r.first.samps_per_buffer
+            << std::setw(16) << r.first.recv_buff_size
+            << std::setw(10) << r.second.tx_batch
+            << std::setw(10) << r.second.rx_batch
+            << std::setw(12) << std::fixed << std::setprecision(2) << r.second.tx_mbps
+            << std::setw(12) << r.second.rx_mbps
+            << std::setw(10) << r.second.tx_errors
+            << std::setw(10) << r.second.tx_underflows
+            << std::setw(10) << r.second.rx_errors
+            << std::setw(10) << r.second.rx_overflows
+            << std::setw(10) << r.second.drops << "\n";
+    }
 
-    std::cout << "\nTest completed. Final RX samples: " << total_rx_samples << std::endl;
+    // ÿҳÿִϵεÿ̯С
+    std::cout << "\nCall overhead (per call; recv() time includes waiting for data)\n"
+        << std::setw(8) << "spp" << std::setw(10) << "TX batch" << std::setw(12) << "send()/s"
+        << std::setw(10) << "us/call" << std::setw(10) << "CPU us" << std::setw(10) << "CPU/samp"
+        << std::setw(10) << "RX batch" << std::setw(12) << "recv()/s" << std::setw(12) << "samps/call"
+        << std::setw(10) << "us/call" << std::setw(10) << "CPU us" << std::setw(10) << "CPU/samp" << "\n";
+    for (const auto& r : results)
+    {
+        const trial_result& t = r.second;
+        const double tx_calls = double(std::max<uint64_t>(t.tx_calls, 1));
+        const double rx_calls = double(std::max<uint64_t>(t.rx_calls, 1));
+        std::cout << std::setw(8) << r.first.samps_per_buffer << std::fixed << std::setprecision(1)
+            << std::setw(10) << t.tx_batch
+            << std::setw(12) << t.tx_calls / t.elapsed
+            << std::setw(10) << t.tx_call_ns / tx_calls / 1e3
+            << std::setw(10) << t.tx_cpu_ns / tx_calls / 1e3
+            << std::setw(10) << (t.tx_samples > 0 ? double(t.tx_cpu_ns) / double(t.tx_samples) : 0.0)
+            << std::setw(10) << t.rx_batch
+            << std::setw(12) << t.rx_calls / t.elapsed
+            << std::setw(12) << t.rx_samples / rx_calls
+            << std::setw(10) << t.rx_call_ns / rx_calls / 1e3
+            << std::setw(10) << t.rx_cpu_ns / rx_calls / 1e3
+            << std::setw(10) << (t.rx_samples > 0 ? double(t.rx_cpu_ns) / double(t.rx_samples) : 0.0) << "\n";
+    }
+    std::cout << std::flush;
     return 0;
-}
\ No newline at end of file
+}
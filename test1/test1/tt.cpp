@@ -1,8 +0,0 @@
-#include<iostream>
-using namespace std;
-
-int main()
-{
-	cout << "hello world!" << endl;
-	return 0;
-}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include "tx_flow.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+tx_flow_controller::tx_flow_controller(const tx_flow_params& params, double rate, size_t packet_samps, size_t max_batch)
+    : params_(params), rate_(rate), packet_(std::max<size_t>(1, packet_samps)),
+    max_batch_(max_batch >= packet_ ? max_batch / packet_ * packet_ : std::max<size_t>(1, max_batch))
+{
+    if (rate <= 0 || params_.target_latency <= 0 || params_.backoff <= 1)
+        throw std::invalid_argument("TX flow control needs a positive rate and target latency and a backoff above 1");
+    // ǰһڷ䣬һ·
+    target_ = std::max(2 * packet_, round_packets(params_.target_latency * rate_));
+    max_depth_ = std::max(target_, round_packets(params_.max_latency * rate_));
+    set_depth(target_);
+}
+
+size_t tx_flow_controller::round_packets(double samps) const
+{
+    return size_t(std::ceil(samps / double(packet_))) * packet_;
+}
+
+void tx_flow_controller::set_depth(size_t depth)
+{
+    depth_ = std::min(max_depth_, std::max(target_, depth));
+    // ʩӣmax_batchСһʱÿmax_batchᳬ÷Ļ
+    batch_ = std::min(max_batch_, std::max(packet_, depth_ / 4 / packet_ * packet_));
+}
+
+void tx_flow_controller::start(int64_t start_ns)
+{
+    anchor_ns_ = start_ns;
+    last_change_ = start_ns;
+    sent_ = 0;
+}
+
+double tx_flow_controller::consumed(int64_t now_ns) const
+{
+    return std::max(0.0, double(now_ns - anchor_ns_) * 1e-9 * rate_);
+}
+
+bool tx_flow_controller::update(uint64_t underflows, int64_t now_ns)
+{
+    if (underflows != seen_underflows_)
+    {
+        seen_underflows_ = underflows;
+        // Ƿ˵豸Ѿգ˿֮ǰ㶼
+        anchor_ns_ = now_ns - int64_t(double(sent_) / rate_ * 1e9);
+        last_change_ = now_ns;
+        if (now_ns < holdoff_until_ || depth_ == max_depth_)
+            return false;
+        set_depth(round_packets(double(depth_) * params_.backoff));
+        holdoff_until_ = now_ns + int64_t(2 * latency() * 1e9);
+        adjustments_++;
+        return true;
+    }
+    if (depth_ > target_ && double(now_ns - last_change_) * 1e-9 >= params_.probe_interval)
+    {
+        set_depth(size_t(double(depth_) * 0.9) / packet_ * packet_);
+        last_change_ = now_ns;
+        adjustments_++;
+        return true;
+    }
+    return false;
+}
+
+int64_t tx_flow_controller::next_send(int64_t now_ns) const
+{
+    // һǰdepthĵҪﵽsent + batch - depth
+    const double need = double(sent_ + batch_) - double(depth_);
+    if (need <= consumed(now_ns))
+        return now_ns;
+    return anchor_ns_ + int64_t(need / rate_ * 1e9);
+}
+
+int64_t tx_flow_controller::ahead_ns(int64_t now_ns) const
+{
+    return std::max<int64_t>(0, int64_t((double(sent_) - consumed(now_ns)) / rate_ * 1e9));
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Ӧز
+struct tx_flow_params
+{
+    double target_latency = 0;      // Ŀ귢ǰ()send()豸ʱ䣬0ʾ
+    double max_latency = 0.1;       // ǰ()
+    double backoff = 1.5;           // ǷغǰԸϵ
+    double probe_interval = 5.0;    // ôûǷʱǰĿСԼ10%
+
+    bool enabled() const { return target_latency > 0; }
+};
+
+// Ӧأ̰߳ʱӹ豸ĵֻǰdepthʱŷһ
+// 豸е˱depthңǱUHD
+// 첽Ϣ̱߳ǷʱǰbackoffͬһǷصĶϢֻһΣԴ˿Ϊ豸յʱ¶룻
+// ʱǷʱ𲽼Ŀֵÿȡǰ1/4ȡκ¶max_batchͻ
+// Ƽ豸ʱһ£֮Ƶ¶֮ۻΪǰ
+// ֻɷ̵߳ãʱ䵥λΪsteady_clock
+class tx_flow_controller
+{
+public:
+    tx_flow_controller(const tx_flow_params& params, double rate, size_t packet_samps, size_t max_batch);
+
+    // start_nsΪ豸ʼʱ䣻ʱʱΪʼʱ̣֮ǰ͵㶼ǰ
+    void start(int64_t start_ns);
+
+    // underflowsΪ첽Ϣ߳ۼƵǷǰСǷı
+    bool update(uint64_t underflows, int64_t now_ns);
+
+    // һԷ͵ʱ̣now_ns
+    int64_t next_send(int64_t now_ns) const;
+
+    // Ƶĵǰǰ(ns)
+    int64_t ahead_ns(int64_t now_ns) const;
+
+    void sent(size_t nsamps) { sent_ += nsamps; }
+
+    size_t depth() const { return depth_; }
+    size_t batch() const { return batch_; }
+    double latency() const { return double(depth_) / rate_; }
+    uint64_t adjustments() const { return adjustments_; }
+
+private:
+    size_t round_packets(double samps) const;
+    void set_depth(size_t depth);
+    double consumed(int64_t now_ns) const;
+
+    const tx_flow_params params_;
+    const double rate_;
+    const size_t packet_;
+    const size_t max_batch_;
+    size_t target_ = 0;
+    size_t max_depth_ = 0;
+    size_t depth_ = 0;
+    size_t batch_ = 0;
+    int64_t anchor_ns_ = 0;         // 豸Ϊաʼsent_֮ʱ̻
+    uint64_t sent_ = 0;
+    uint64_t seen_underflows_ = 0;
+    int64_t holdoff_until_ = 0;     // ǰǷϢΪͬһǷ
+    int64_t last_change_ = 0;
+    uint64_t adjustments_ = 0;
+};
@@ -0,0 +1,178 @@
+#include "tx_stream.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+    int64_t steady_ns(std::chrono::steady_clock::time_point t)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+    }
+
+    void publish_flow(tx_channel& tx, const tx_flow_controller& flow)
+    {
+        tx.metrics.flow_depth.set(flow.depth());
+        tx.metrics.flow_batch.set(flow.batch());
+        tx.metrics.flow_adjustments.set(flow.adjustments());
+    }
+}
+
+void tx_worker(tx_channel& tx, const test_config& cfg, const std::vector<char*>& tx_buffs,
+    const start_schedule& start, const std::atomic<bool>& tx_done)
+{
+    uhd::tx_metadata_t md;
+    md.start_of_burst = true;
+    md.end_of_burst = false;
+    // ʱʱһʱ豸ʱ̲ſʼ
+    md.has_time_spec = start.timed;
+    md.time_spec = start.device_time;
+
+    const size_t batch = tx.batch;
+    size_t buff_idx = 0;
+    size_t buff_off = 0;      // ǰԤɻѷ͵
+    size_t num_sent = 0;
+    uint64_t frame = 0;
+    uint64_t play_pos = 0;
+    size_t live_len = 0;      // ʵʱɻһ
+    size_t live_off = 0;      // ѷ͵
+    const int64_t cpu_start = thread_cpu_ns();
+    const double default_timeout = 0.1; // ޸óʱʱΪ100ms
+
+    // Сȡδʱʱ豸յһͿʼ
+    std::unique_ptr<tx_flow_controller> flow;
+    if (cfg.tx_flow.enabled())
+    {
+        flow.reset(new tx_flow_controller(cfg.tx_flow, tx.rate, tx.stream->get_max_num_samps(), batch));
+        flow->start(steady_ns(start.timed ? start.host_time : std::chrono::steady_clock::now()));
+        publish_flow(tx, *flow);
+    }
+
+    while (!tx_done) {
+        size_t want = batch;
+        if (flow)
+        {
+            int64_t now = steady_ns(std::chrono::steady_clock::now());
+            if (flow->update(tx.async.underflows, now))
+                publish_flow(tx, *flow);
+            // ȴ豸ĵܷһһǰ(max_latency)
+            const int64_t due = flow->next_send(now);
+            if (due > now)
+            {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(due - now));
+                now = steady_ns(std::chrono::steady_clock::now());
+            }
+            tx.metrics.send_ahead.record(uint64_t(flow->ahead_ns(now)));
+            want = std::min(flow->batch(), batch);
+        }
+        // һһʱδĲ´νŷźű
+        if (tx.gen && live_off == live_len)
+        {
+            tx.gen->generate(tx.live_buff, want, cfg.cpu_format);
+            live_len = want;
+            live_off = 0;
+        }
+        const auto call_start = std::chrono::steady_clock::now();
+        // ʼʱ֮ǰ豸send()һֱʼʱҪεȴ
+        double timeout = default_timeout;
+        if (start.timed && call_start < start.host_time)
+            timeout += std::chrono::duration<double>(start.host_time - call_start).count();
+        // ģʽÿֻΪһ֡֡PN
+        if (tx.frames != nullptr && buff_idx == 0 && buff_off == 0)
+            tx.frames->mark(frame++, steady_ns(call_start));
+        // طʱֱӰӳsend()ļĩβһʱʣಿ
+        const char* buff = nullptr;
+        size_t nsamps = want;
+        if (tx.playback != nullptr)
+            nsamps = tx.playback->read(play_pos, want, buff);
+        else if (tx.gen)
+        {
+            nsamps = live_len - live_off;
+            buff = tx.live_buff + live_off * cfg.bytes_per_samp;
+        }
+        else
+        {
+            // һ绺ʱδĲ´νŷźű
+            nsamps = std::min(want, batch - buff_off);
+            buff = tx_buffs[buff_idx] + buff_off * cfg.bytes_per_samp;
+        }
+        num_sent = tx.stream->send(buff, nsamps, md, timeout);
+        const uint64_t call_ns = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - call_start).count());
+        tx.metrics.send_latency.record(call_ns);
+        ++tx.metrics.calls;
+        tx.metrics.call_ns += call_ns;
+        if (flow)
+            flow->sent(num_sent);
+
+        // ûsend()ʱ豸ǷأǷ첽Ϣֻ߳ϲ̨
+        if (num_sent < nsamps)
+            ++tx.metrics.errors;
+
+        tx.metrics.samples += num_sent;
+        if (tx.playback != nullptr)
+        {
+            play_pos += num_sent;
+            if (play_pos == tx.playback->num_samps())
+            {
+                if (!tx.playback->loop())
+                {
+                    std::cout << "TX ch" << tx.chan << " playback finished" << std::endl;
+                    break;
+                }
+                play_pos = 0;
+            }
+        }
+        else if (tx.gen)
+            live_off += num_sent;
+        else
+        {
+            buff_off += num_sent;
+            if (buff_off == batch)
+            {
+                buff_idx = (buff_idx + 1) % tx_buffs.size();
+                buff_off = 0;
+            }
+        }
+        md.start_of_burst = false;
+        md.has_time_spec = false;
+    }
+
+    md.end_of_burst = true;
+    tx.stream->send("", 0, md);
+    tx.metrics.cpu_ns += uint64_t(thread_cpu_ns() - cpu_start);
+}
+
+void tx_async_worker(tx_channel& tx, const std::atomic<bool>& async_done)
+{
+    // recv_async_msg()޷ⲿѣʱȡý϶̣async_done֮ܿ˳
+    const double timeout = 0.02;
+    uhd::async_metadata_t async_md;
+    while (!async_done)
+    {
+        if (!tx.stream->recv_async_msg(async_md, timeout))
+            continue;
+
+        switch (async_md.event_code)
+        {
+        case uhd::async_metadata_t::EVENT_CODE_BURST_ACK:
+            ++tx.async.burst_acks;
+            tx.burst_acked.set();
+            break;
+        case uhd::async_metadata_t::EVENT_CODE_UNDERFLOW:
+        case uhd::async_metadata_t::EVENT_CODE_UNDERFLOW_IN_PACKET:
+            ++tx.async.underflows;
+            break;
+        case uhd::async_metadata_t::EVENT_CODE_SEQ_ERROR:
+        case uhd::async_metadata_t::EVENT_CODE_SEQ_ERROR_IN_BURST:
+            ++tx.async.seq_errors;
+            break;
+        case uhd::async_metadata_t::EVENT_CODE_TIME_ERROR:
+            ++tx.async.time_errors;
+            break;
+        default:
+            break;
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "event_flag.h"
+#include "loopback.h"
+#include "metrics.h"
+#include "playback.h"
+#include "signal_gen.h"
+#include "stream_config.h"
+#include <uhd/stream.hpp>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// ͨһӦһ̺߳һ첽Ϣֻ̣߳дԼļ
+struct tx_channel
+{
+    tx_channel(size_t chan_, uhd::tx_streamer::sptr stream_) : chan(chan_), stream(stream_) {}
+
+    size_t chan;
+    uhd::tx_streamer::sptr stream;
+    size_t batch = 0;         // ÿsend()ӦʱΪ
+    double rate = 0;          // ʵʲ
+    tx_metrics metrics;       // ߳д
+    tx_async_metrics async;   // 첽Ϣ߳д
+    frame_clock* frames = nullptr; // ģʽ¼¼ÿ֡ķʱ
+    playback_file* playback = nullptr; // طģʽ´ļӳ
+    std::unique_ptr<signal_generator> gen; // ʵʱģʽÿsend()ǰһ
+    char* live_buff = nullptr;
+    event_flag burst_acked;   // 첽Ϣ߳յͻACKʱλֹͣʱȴһͻ
+    char* relay_buff = nullptr;    // мģʽ´壬Ϊһտ
+    relay_metrics relay;      // м߳д
+};
+
+typedef std::vector<std::unique_ptr<tx_channel>> tx_channels_t;
+
+// ̣߳ѭԤɵĻطģʽηļе㣬ʵʱģʽÿηɵ
+// Ӧʱtx_flow_controllerÿͷʱ̣ԤɵĻз
+void tx_worker(tx_channel& tx, const test_config& cfg, const std::vector<char*>& tx_buffs,
+    const start_schedule& start, const std::atomic<bool>& tx_done);
+
+// ߳̽ʱͽͻ(EOB)豸껺еظͻACK
+// 첽Ϣ̣߳ͳ豸ϱǷءŴʱͻȷ
+void tx_async_worker(tx_channel& tx, const std::atomic<bool>& async_done);
@@ -0,0 +1,161 @@
+#include "work_pool.h"
+#include <chrono>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+    // ôȡ
+    const int IDLE_SPINS = 64;
+
+    struct spin_guard
+    {
+        explicit spin_guard(std::atomic_flag& f) : flag(f)
+        {
+            while (flag.test_and_set(std::memory_order_acquire))
+                std::this_thread::yield();
+        }
+        ~spin_guard() { flag.clear(std::memory_order_release); }
+
+        std::atomic_flag& flag;
+    };
+}
+
+bool work_pool::task_deque::push_back(void* task)
+{
+    spin_guard guard(lock);
+    if (count == slots.size())
+        return false;
+    slots[(head + count) % slots.size()] = task;
+    count++;
+    return true;
+}
+
+void* work_pool::task_deque::pop_front()
+{
+    spin_guard guard(lock);
+    if (count == 0)
+        return nullptr;
+    void* task = slots[head];
+    head = (head + 1) % slots.size();
+    count--;
+    return task;
+}
+
+work_pool::work_pool(size_t threads, size_t queue_depth, task_fn fn, const thread_placement& placement)
+    : fn_(std::move(fn))
+{
+    if (threads == 0 || queue_depth == 0)
+        throw std::invalid_argument("Work pool needs at least one thread and one queue slot");
+    for (size_t i = 0; i < threads; i++)
+        workers_.emplace_back(new worker(queue_depth));
+    for (size_t i = 0; i < threads; i++)
+        workers_[i]->thread = start_thread(placement.for_thread(i), &work_pool::worker_loop, this, i);
+}
+
+work_pool::~work_pool()
+{
+    if (!finished_)
+        finish();
+}
+
+bool work_pool::submit(void* task, size_t hint)
+{
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    // ȼqueued_ٶsleepers_park()е˳෴һ߿Է
+    queued_.fetch_add(1, std::memory_order_seq_cst);
+    for (size_t i = 0; i < workers_.size(); i++)
+    {
+        if (workers_[(hint + i) % workers_.size()]->queue.push_back(task))
+        {
+            if (sleepers_.load(std::memory_order_seq_cst) > 0)
+            {
+                std::lock_guard<std::mutex> lock(park_mutex_);
+                park_cv_.notify_one();
+            }
+            return true;
+        }
+    }
+    queued_.fetch_sub(1, std::memory_order_relaxed);
+    pending_.fetch_sub(1, std::memory_order_relaxed);
+    return false;
+}
+
+void* work_pool::take(size_t index)
+{
+    worker& self = *workers_[index];
+    void* task = self.queue.pop_front();
+    if (task != nullptr)
+    {
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        return task;
+    }
+
+    // һ߳̿ʼңп̶߳ͬһ
+    for (size_t i = 1; i < workers_.size(); i++)
+    {
+        task = workers_[(index + i) % workers_.size()]->queue.pop_front();
+        if (task != nullptr)
+        {
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            ++self.metrics.steals;
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+void work_pool::park()
+{
+    std::unique_lock<std::mutex> lock(park_mutex_);
+    sleepers_.fetch_add(1, std::memory_order_seq_cst);
+    // submit()ڼ֪ͨͿʼȴ֮䲻©
+    if (queued_.load(std::memory_order_seq_cst) == 0 && !stop_.load(std::memory_order_acquire))
+        park_cv_.wait(lock);
+    sleepers_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void work_pool::worker_loop(size_t index)
+{
+    using clock = std::chrono::steady_clock;
+    worker& self = *workers_[index];
+    int idle = 0;
+    while (true)
+    {
+        void* task = take(index);
+        if (task == nullptr)
+        {
+            if (stop_.load(std::memory_order_acquire) && pending_.load(std::memory_order_acquire) == 0)
+                break;
+            if (++idle < IDLE_SPINS)
+                std::this_thread::yield();
+            else
+            {
+                park();
+                idle = 0;
+            }
+            continue;
+        }
+        idle = 0;
+        const auto t0 = clock::now();
+        fn_(index, task);
+        self.metrics.busy_ns += uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - t0).count());
+        ++self.metrics.tasks;
+        pending_.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+void work_pool::finish()
+{
+    finished_ = true;
+    stop_.store(true, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(park_mutex_);
+        park_cv_.notify_all();
+    }
+    for (auto& w : workers_)
+    {
+        if (w->thread.joinable())
+            w->thread.join();
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "metrics.h"
+#include "thread_placement.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ÿ̵߳ļֻɸ߳д
+struct alignas(CACHE_LINE_SIZE) pool_metrics
+{
+    counter tasks;                  // ִеȡ
+    counter steals;                 // ̶߳ȡ
+    counter busy_ns;                // ִĺʱ
+};
+
+// ȡ̳߳أÿ߳һн˫˶Уύ߰hintĳ̵߳Ķβ
+// ߳ȡԼԼĶпٴ̵߳Ķȡ
+// ύǿ鴦񣬽Ҫ˶ȡǰĿ
+// вλڹʱ䣬ڼ䲻ڴ棻ÿһٽֻмζд
+// ߳óCPUһСʱ䣬ʱߣsubmit()ѣռ
+class work_pool
+{
+public:
+    typedef std::function<void(size_t worker, void* task)> task_fn;
+
+    // queue_depthΪÿеĲλfnڹִ߳УΪ߳ź
+    work_pool(size_t threads, size_t queue_depth, task_fn fn, const thread_placement& placement);
+    ~work_pool();
+
+    work_pool(const work_pool&) = delete;
+    work_pool& operator=(const work_pool&) = delete;
+
+    // hint % threads̵߳ĶУʱγԺ̣߳ȫʱfalse
+    // ֻһ̵߳
+    bool submit(void* task, size_t hint);
+
+    // ȴύִ겢ֹͣ߳
+    void finish();
+
+    size_t threads() const { return workers_.size(); }
+    const pool_metrics& metrics(size_t worker) const { return workers_[worker]->metrics; }
+
+private:
+    struct task_deque
+    {
+        explicit task_deque(size_t capacity) : slots(capacity) {}
+
+        bool push_back(void* task);
+        void* pop_front();
+
+        std::vector<void*> slots;
+        size_t head = 0;            // λ
+        size_t count = 0;
+        std::atomic_flag lock = ATOMIC_FLAG_INIT;
+    };
+
+    struct worker
+    {
+        explicit worker(size_t depth) : queue(depth) {}
+
+        alignas(CACHE_LINE_SIZE) task_deque queue;
+        pool_metrics metrics;
+        std::thread thread;
+    };
+
+    void worker_loop(size_t index);
+    void* take(size_t index);
+    void park();
+
+    task_fn fn_;
+    std::vector<std::unique_ptr<worker>> workers_;
+    std::atomic<size_t> pending_{ 0 };  // ύδɵ
+    std::atomic<size_t> queued_{ 0 };   // ύδȡߵ
+    std::atomic<size_t> sleepers_{ 0 }; // park_cv_߻򼴽ߵ߳
+    std::atomic<bool> stop_{ false };
+    std::mutex park_mutex_;
+    std::condition_variable park_cv_;
+    bool finished_ = false;
+};
@@ -1,12 +0,0 @@
-﻿// usrp.cpp: 定义应用程序的入口点。
-//
-
-#include "usrp.h"
-
-using namespace std;
-
-int main()
-{
-	cout << "Hello CMake." << endl;
-	return 0;
-}